@@ -0,0 +1,55 @@
+// limb buffer allocations of gcd, sqrt, pow_mod and an in-place x *= b,
+// x %= m loop, without and with a LimbPool around the loop.
+#include "integer/math.hpp"
+#include "integer/pool.hpp"
+#include <chrono>
+#include <cstdio>
+#include <functional>
+
+using namespace lll;
+
+static void run(const char *name, const std::function<void()> &job) {
+  for (int pooled = 0; pooled < 2; pooled++) {
+    const LimbStats before = limb_stats();
+    const auto start = std::chrono::steady_clock::now();
+    if (pooled) {
+      LimbPool pool;
+      job();
+    } else {
+      job();
+    }
+    const auto stop = std::chrono::steady_clock::now();
+    const LimbStats after = limb_stats();
+    std::printf("%-8s %-6s heap %10llu  reused %10llu  %8.1f ms\n", name,
+                pooled ? "pooled" : "plain",
+                (unsigned long long)(after.heap - before.heap),
+                (unsigned long long)(after.reused - before.reused),
+                std::chrono::duration<double, std::milli>(stop - start)
+                    .count());
+  }
+}
+
+int main() {
+  const Integer a = pow(3, 757);  // 1200 bits
+  const Integer b = pow(7, 391);  // 1098 bits
+  const Integer m = pow(5, 441);  // 1024 bits, odd
+  const Integer n = pow(11, 578); // 2000 bits
+
+  run("gcd", [&] {
+    for (int i = 0; i < 200; i++) gcd(a + i, b);
+  });
+  run("sqrt", [&] {
+    for (int i = 0; i < 20; i++) sqrt(n + i);
+  });
+  run("pow_mod", [&] {
+    for (int i = 0; i < 50; i++) pow_mod(a + i, b, m);
+  });
+  Integer x = a;
+  run("mul_mod", [&] {
+    for (int i = 0; i < 20000; i++) {
+      x *= b;
+      x %= m;
+    }
+  });
+  return 0;
+}
@@ -1,14 +1,17 @@
 #ifndef LLL_INTEGER_H
 #define LLL_INTEGER_H
 
+#include "integer/limbs.hpp"
 #include <cstdint>
 #include <string>
-#include <vector>
+#include <utility>
 
 namespace lll {
+struct MulExpr;
+
 class Integer {
 public:
-  using VecView = std::vector<uint64_t>;
+  using VecView = LimbVec;
 
   Integer(const Integer &other) = default;
   Integer(Integer &&other) = default;
@@ -35,7 +38,20 @@ public:
   uint64_t pow_of_2() const; // max{ e | x = d * 2 ^ e }
   uint64_t abs_log2() const; // floor(log2(|x|)), x != 0
   Integer abs() const { return neg_ ? -*this : *this; }
+  // -x in place: only the sign changes
+  Integer &negate() {
+    neg_ = !(zero() || neg_);
+    return *this;
+  }
   const VecView &view_v() const { return abs_val_; }
+  // the value with the little-endian limbs p[0, n), negated if neg; the
+  // inverse of view_v()
+  static Integer from_limbs(const uint64_t *p, size_t n, bool neg = false) {
+    while (n && p[n - 1] == 0) n--;
+    VecView v;
+    v.assign(p, p + n);
+    return Integer(neg && n, std::move(v));
+  }
 
   bool operator<(const Integer &other) const { return cmp(*this, other) < 0; }
 
@@ -76,18 +92,41 @@ public:
   Integer operator++(int) = delete;
   Integer operator--(int) = delete;
 
-  Integer operator+(const Integer &other) const {
+  // the && overloads work in the buffer of an operand that is about to go
+  // away and return it, so chains on temporaries allocate nothing new.
+
+  Integer operator+(const Integer &other) const & {
     Integer out;
     add(*this, other, out);
     return out;
   }
 
-  Integer operator+(const int64_t other) const {
+  Integer operator+(const Integer &other) && {
+    add(*this, other, *this);
+    return std::move(*this);
+  }
+
+  Integer operator+(Integer &&other) const & {
+    add(*this, other, other);
+    return std::move(other);
+  }
+
+  Integer operator+(Integer &&other) && {
+    add(*this, other, *this);
+    return std::move(*this);
+  }
+
+  Integer operator+(const int64_t other) const & {
     Integer out;
     add_64bits(*this, other, out);
     return out;
   }
 
+  Integer operator+(const int64_t other) && {
+    add_64bits(*this, other, *this);
+    return std::move(*this);
+  }
+
   Integer &operator+=(const Integer &other) {
     add(*this, other, *this);
     return *this;
@@ -98,29 +137,54 @@ public:
     return *this;
   }
 
+  // y += product(a, b), with no temporary; see integer/expr.hpp
+  Integer &operator+=(const MulExpr &e);
+
   Integer &operator++() {
     add_64bits(*this, 1, *this);
     return *this;
   }
 
-  Integer operator-() const {
+  Integer operator-() const & {
     Integer out;
     opp(*this, out);
     return out;
   }
 
-  Integer operator-(const Integer &other) const {
+  Integer operator-() && { return std::move(negate()); }
+
+  Integer operator-(const Integer &other) const & {
     Integer out;
     sub(*this, other, out);
     return out;
   }
 
-  Integer operator-(const int64_t other) const {
+  Integer operator-(const Integer &other) && {
+    sub(*this, other, *this);
+    return std::move(*this);
+  }
+
+  Integer operator-(Integer &&other) const & {
+    sub(*this, other, other);
+    return std::move(other);
+  }
+
+  Integer operator-(Integer &&other) && {
+    sub(*this, other, *this);
+    return std::move(*this);
+  }
+
+  Integer operator-(const int64_t other) const & {
     Integer out;
     sub_64bits(*this, other, out);
     return out;
   }
 
+  Integer operator-(const int64_t other) && {
+    sub_64bits(*this, other, *this);
+    return std::move(*this);
+  }
+
   Integer &operator-=(const Integer &other) {
     sub(*this, other, *this);
     return *this;
@@ -131,23 +195,46 @@ public:
     return *this;
   }
 
+  // y -= product(a, b)
+  Integer &operator-=(const MulExpr &e);
+
   Integer &operator--() {
     sub_64bits(*this, 1, *this);
     return *this;
   }
 
-  Integer operator*(const Integer &other) const {
+  Integer operator*(const Integer &other) const & {
     Integer out;
     mul(*this, other, out);
     return out;
   }
 
-  Integer operator*(const int64_t other) const {
+  Integer operator*(const Integer &other) && {
+    mul(*this, other, *this);
+    return std::move(*this);
+  }
+
+  Integer operator*(Integer &&other) const & {
+    mul(*this, other, other);
+    return std::move(other);
+  }
+
+  Integer operator*(Integer &&other) && {
+    mul(*this, other, *this);
+    return std::move(*this);
+  }
+
+  Integer operator*(const int64_t other) const & {
     Integer out;
     mul_64bits(*this, other, out);
     return out;
   }
 
+  Integer operator*(const int64_t other) && {
+    mul_64bits(*this, other, *this);
+    return std::move(*this);
+  }
+
   Integer &operator*=(const Integer &other) {
     mul(*this, other, *this);
     return *this;
@@ -158,18 +245,38 @@ public:
     return *this;
   }
 
-  Integer operator/(const Integer &other) const {
+  Integer operator/(const Integer &other) const & {
     Integer out;
     div(*this, other, out);
     return out;
   }
 
-  Integer operator/(const int64_t other) const {
+  Integer operator/(const Integer &other) && {
+    div(*this, other, *this);
+    return std::move(*this);
+  }
+
+  Integer operator/(Integer &&other) const & {
+    div(*this, other, other);
+    return std::move(other);
+  }
+
+  Integer operator/(Integer &&other) && {
+    div(*this, other, *this);
+    return std::move(*this);
+  }
+
+  Integer operator/(const int64_t other) const & {
     Integer out;
     div_64bits(*this, other, out);
     return out;
   }
 
+  Integer operator/(const int64_t other) && {
+    div_64bits(*this, other, *this);
+    return std::move(*this);
+  }
+
   Integer &operator/=(const Integer &other) {
     div(*this, other, *this);
     return *this;
@@ -180,13 +287,36 @@ public:
     return *this;
   }
 
-  Integer operator%(const Integer &other) const {
+  Integer operator%(const Integer &other) const & {
     Integer out;
     mod(*this, other, out);
     return out;
   }
 
-  int64_t operator%(const int64_t other) const {
+  Integer operator%(const Integer &other) && {
+    mod(*this, other, *this);
+    return std::move(*this);
+  }
+
+  Integer operator%(Integer &&other) const & {
+    mod(*this, other, other);
+    return std::move(other);
+  }
+
+  Integer operator%(Integer &&other) && {
+    mod(*this, other, *this);
+    return std::move(*this);
+  }
+
+  int64_t operator%(const int64_t other) const & {
+    int64_t out;
+    mod_64bits(*this, other, out);
+    return out;
+  }
+
+  // as above; without it (a * b) % 7 would be ambiguous with the Integer&&
+  // overload
+  int64_t operator%(const int64_t other) && {
     int64_t out;
     mod_64bits(*this, other, out);
     return out;
@@ -203,23 +333,33 @@ public:
     return *this = out;
   }
 
-  Integer operator<<(const uint64_t other) const {
+  Integer operator<<(const uint64_t other) const & {
     Integer out;
     shl_abs(*this, other, out);
     return out;
   }
 
+  Integer operator<<(const uint64_t other) && {
+    shl_abs(*this, other, *this);
+    return std::move(*this);
+  }
+
   Integer &operator<<=(const uint64_t other) {
     shl_abs(*this, other, *this);
     return *this;
   }
 
-  Integer operator>>(const uint64_t other) const {
+  Integer operator>>(const uint64_t other) const & {
     Integer out;
     shr_abs(*this, other, out);
     return out;
   }
 
+  Integer operator>>(const uint64_t other) && {
+    shr_abs(*this, other, *this);
+    return std::move(*this);
+  }
+
   Integer &operator>>=(const uint64_t other) {
     shr_abs(*this, other, *this);
     return *this;
@@ -227,6 +367,9 @@ public:
 
   friend std::istream &operator>>(std::istream &is, Integer &a);
   friend std::ostream &operator<<(std::ostream &os, const Integer &a);
+  // binary records, see integer/binary.hpp
+  friend size_t deserialize(const void *src, size_t bytes, Integer &x);
+  friend std::istream &deserialize(std::istream &is, Integer &x);
 
   // 1: a > b; 0: a == b; -1: a < b
   static int cmp(const Integer &a, const Integer &b);
@@ -238,6 +381,8 @@ public:
   static void sub(const Integer &a, const Integer &b, Integer &out);
   // a * b
   static void mul(const Integer &a, const Integer &b, Integer &out);
+  // a * a
+  static void sqr(const Integer &a, Integer &out);
   // a % b
   static void mod(const Integer &a, const Integer &b, Integer &out);
   // quot = a / b, rem = a % b
@@ -247,6 +392,22 @@ public:
   static void shl_abs(const Integer &a, uint64_t b, Integer &out);
   // a / pow(2, b)
   static void shr_abs(const Integer &a, uint64_t b, Integer &out);
+  // fused forms of the above, with no intermediate values
+  // a * b + c
+  static void addmul(const Integer &a, const Integer &b, const Integer &c,
+                     Integer &out);
+  // a * b - c
+  static void submul(const Integer &a, const Integer &b, const Integer &c,
+                     Integer &out);
+  // a * b % m
+  static void mulmod(const Integer &a, const Integer &b, const Integer &m,
+                     Integer &out);
+  // (a + b) / pow(2, s)
+  static void add_shr(const Integer &a, const Integer &b, uint64_t s,
+                      Integer &out);
+  // (a - b) / pow(2, s)
+  static void sub_shr(const Integer &a, const Integer &b, uint64_t s,
+                      Integer &out);
 
   static int cmp_64bits(const Integer &a, int64_t b);
   static void add_64bits(const Integer &a, int64_t b, Integer &out);
@@ -256,9 +417,15 @@ public:
   static void div_64bits(const Integer &a, int64_t b, Integer &quot,
                          int64_t *rem = nullptr);
 
+  // uniform in [0, |bound|], with the sign of bound; see random.hpp
   static Integer random(const Integer &bound);
 
 private:
+  friend class Montgomery;
+  friend class Barrett;
+  friend class Divisor;
+  friend class Divisor64;
+
   Integer(const bool n, VecView &&v) : neg_(n),
     abs_val_(std::move(v)) {
   }
@@ -268,4 +435,6 @@ private:
 };
 } // namespace lll
 
+#include "integer/expr.hpp"
+
 #endif // LLL_INTEGER_H
\ No newline at end of file
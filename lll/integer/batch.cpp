@@ -0,0 +1,138 @@
+#include "batch.hpp"
+#include "divisor.hpp"
+#include "math.hpp"
+#include "modular.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace lll {
+using namespace internal;
+
+// f(i) for i in [0, n), in runs of consecutive elements so the threads do
+// not meet on every item
+template <typename F>
+static void each(const size_t n, const size_t threads, F f) {
+  const size_t k = std::min(thread_count(threads), n);
+  const size_t run = k > 1 ? (n + 8 * k - 1) / (8 * k) : n;
+  parallel_for(run ? (n + run - 1) / run : 0, k, [&](const size_t j) {
+    for (size_t i = j * run, end = std::min(n, i + run); i < end; i++) f(i);
+  });
+}
+
+void mul_many(Integer *out, const Integer *a, const Integer *b,
+              const size_t n, const size_t threads) {
+  each(n, threads, [&](const size_t i) { Integer::mul(a[i], b[i], out[i]); });
+}
+
+void mod_many(Integer *out, const Integer *a, const size_t n,
+              const Integer &m, const size_t threads) {
+  if (m.zero()) throw std::domain_error("Division by zero");
+
+  if (m.view_v().size() == 1) {
+    const Divisor64 d(m.abs_low64());
+    each(n, threads, [&](const size_t i) {
+      const uint64_t r = d.mod(a[i]);
+      out[i] = Integer::from_limbs(&r, 1, a[i].neg());
+    });
+    return;
+  }
+
+  const Divisor d(m);
+  each(n, threads, [&](const size_t i) { out[i] = d.mod(a[i]); });
+}
+
+void pow_mod_many(Integer *out, const Integer *b, const size_t n,
+                  const Integer &e, const Integer &m, const size_t threads) {
+  if (m.neg() || m.zero()) throw std::domain_error("m <= 0.");
+  if (m == 1 || e.neg() || e.zero()) {
+    // nothing to share: the special cases of pow_mod
+    for (size_t i = 0; i < n; i++) out[i] = pow_mod(b[i], e, m);
+    return;
+  }
+
+  // as in pow_mod, the sign follows b ^ e
+  const bool odd_e = e.view_v()[0] & 1;
+  if (m.view_v()[0] & 1) {
+    const Montgomery mont(m);
+    each(n, threads, [&](const size_t i) {
+      const bool neg = b[i].neg() && odd_e;
+      out[i] = mont.pow(b[i].abs() % m, e);
+      if (neg) Integer::opp(out[i], out[i]);
+    });
+    return;
+  }
+
+  const Barrett bar(m);
+  each(n, threads, [&](const size_t i) {
+    const bool neg = b[i].neg() && odd_e;
+    out[i] = bar.pow(b[i].abs() % m, e);
+    if (neg) Integer::opp(out[i], out[i]);
+  });
+}
+
+ProductTree product_tree(const Integer *x, const size_t n,
+                         const size_t threads) {
+  ProductTree tree;
+  if (n == 0) return tree;
+
+  tree.emplace_back(x, x + n);
+  while (tree.back().size() > 1) {
+    const std::vector<Integer> &low = tree.back();
+    std::vector<Integer> up((low.size() + 1) / 2);
+    each(up.size(), threads, [&](const size_t i) {
+      if (2 * i + 1 < low.size())
+        Integer::mul(low[2 * i], low[2 * i + 1], up[i]);
+      else
+        up[i] = low[2 * i];
+    });
+    tree.push_back(std::move(up));
+  }
+  return tree;
+}
+
+// r[i] = a % node[i] (node[i] ^ 2 if squares) for the nodes of every level
+// going down, last the leaves
+static void descend(std::vector<Integer> &r, const ProductTree &tree,
+                    const bool squares, const size_t threads) {
+  std::vector<Integer> next;
+  for (size_t level = tree.size() - 1; level--;) {
+    const std::vector<Integer> &nodes = tree[level];
+    next.resize(nodes.size());
+    each(nodes.size(), threads, [&](const size_t i) {
+      if (!squares) {
+        Integer::mod(r[i / 2], nodes[i], next[i]);
+        return;
+      }
+      Integer sq;
+      Integer::sqr(nodes[i], sq);
+      Integer::mod(r[i / 2], sq, next[i]);
+    });
+    std::swap(r, next);
+  }
+}
+
+void remainder_tree(Integer *out, const Integer &a, const ProductTree &tree,
+                    const size_t threads) {
+  if (tree.empty()) return;
+
+  std::vector<Integer> r(1, a % tree.back()[0]);
+  descend(r, tree, false, threads);
+  std::move(r.begin(), r.end(), out);
+}
+
+void batch_gcd(Integer *out, const Integer *x, const size_t n,
+               const size_t threads) {
+  if (n == 0) return;
+
+  // with p the product of all, (p mod x[i]^2) / x[i] is the product of the
+  // others mod x[i]
+  const ProductTree tree = product_tree(x, n, threads);
+  std::vector<Integer> r(1, tree.back()[0]);
+  descend(r, tree, true, threads);
+  each(n, threads, [&](const size_t i) {
+    r[i] /= tree[0][i];
+    out[i] = gcd(r[i], tree[0][i]);
+  });
+}
+} // namespace lll
@@ -0,0 +1,38 @@
+#ifndef LLL_INTEGER_BATCH_HPP
+#define LLL_INTEGER_BATCH_HPP
+
+#include "../integer.hpp"
+#include <vector>
+
+namespace lll {
+// element-wise operations over arrays of n operands: whatever depends only
+// on the shared operand (a reciprocal, a montgomery context) is computed
+// once for the whole array, and the elements are split over up to threads
+// threads (0: one per core). out may be one of the inputs.
+
+// out[i] = a[i] * b[i]
+void mul_many(Integer *out, const Integer *a, const Integer *b, size_t n,
+              size_t threads = 1);
+// out[i] = a[i] % m, with the sign of Integer::mod
+void mod_many(Integer *out, const Integer *a, size_t n, const Integer &m,
+              size_t threads = 1);
+// out[i] = pow_mod(b[i], e, m)
+void pow_mod_many(Integer *out, const Integer *b, size_t n, const Integer &e,
+                  const Integer &m, size_t threads = 1);
+
+// tree[0] = x[0, n), and each level above holds the products of adjacent
+// pairs of the one below, an odd last element moving up as it is, up to
+// the product of all in tree.back()[0]. the nodes of a level are computed
+// in parallel.
+using ProductTree = std::vector<std::vector<Integer>>;
+ProductTree product_tree(const Integer *x, size_t n, size_t threads = 1);
+// out[i] = a % tree[0][i], by reducing a down the tree: each node gets the
+// remainder of its parent's. remainders two levels apart share buffers.
+void remainder_tree(Integer *out, const Integer &a, const ProductTree &tree,
+                    size_t threads = 1);
+// out[i] = gcd(x[i], the product of the other x[j]) for x[i] > 0: any
+// factor shared between moduli, found without comparing pairs (bernstein)
+void batch_gcd(Integer *out, const Integer *x, size_t n, size_t threads = 1);
+} // namespace lll
+
+#endif // LLL_INTEGER_BATCH_HPP
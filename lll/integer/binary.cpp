@@ -0,0 +1,259 @@
+#include "binary.hpp"
+#include "internal.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace lll {
+using namespace internal;
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+static constexpr bool LITTLE_ENDIAN_HOST = false;
+#else
+static constexpr bool LITTLE_ENDIAN_HOST = true;
+#endif
+
+// header bits besides the size. the checksum bit is also the top one, so
+// no single flipped bit turns a checked record into an unchecked one.
+static constexpr uint64_t NEG = 1, CHECKSUM = 2 | uint64_t(1) << 63;
+
+static size_t size_of(const uint64_t header) { return header << 1 >> 3; }
+
+static bool has_checksum(const uint64_t header) { return header & 2; }
+
+// the two checksum bits agree, and the magnitude has no high zero limb or
+// is not -0; top is its top limb
+static bool well_formed(const uint64_t header, const uint64_t top) {
+  if (has_checksum(header) != header >> 63) return false;
+  return size_of(header) ? top != 0 : !(header & NEG);
+}
+
+static uint64_t bswap64(uint64_t x) {
+  x = (x & 0x00ff00ff00ff00ff) << 8 | (x >> 8 & 0x00ff00ff00ff00ff);
+  x = (x & 0x0000ffff0000ffff) << 16 | (x >> 16 & 0x0000ffff0000ffff);
+  return x << 32 | x >> 32;
+}
+
+static uint64_t to_le(const uint64_t x) {
+  return LITTLE_ENDIAN_HOST ? x : bswap64(x);
+}
+
+static void store64(char *p, const uint64_t x) {
+  const uint64_t le = to_le(x);
+  memcpy(p, &le, 8);
+}
+
+static uint64_t load64(const char *p) {
+  uint64_t le;
+  memcpy(&le, p, 8);
+  return to_le(le);
+}
+
+// each step is a bijection of the state for a fixed word and of the word for
+// a fixed state, so a record differing in one word always sums differently
+static uint64_t checksum_of(const uint64_t header, const uint64_t *p,
+                            const size_t n) {
+  uint64_t h = 0;
+  for (size_t i = 0; i <= n; i++) {
+    h = (h ^ (i ? p[i - 1] : header)) * 0x9e3779b97f4a7c15;
+    h ^= h >> 32;
+  }
+  return h;
+}
+
+static uint64_t header_of(const Integer &x, const bool checksum) {
+  return static_cast<uint64_t>(x.view_v().size()) << 2 |
+         (checksum ? CHECKSUM : 0) | (x.neg() ? NEG : 0);
+}
+
+static size_t record_bytes(const uint64_t header) {
+  return 8 * (size_of(header) + 1 + has_checksum(header));
+}
+
+// the header of the record at p, after checking that the record is well
+// formed and fits in bytes
+static uint64_t read_header(const char *p, const size_t bytes) {
+  if (bytes < 8) throw std::invalid_argument("Truncated record");
+  const uint64_t header = load64(p);
+  const size_t n = size_of(header), sum = has_checksum(header);
+  const size_t room = bytes / 8 - 1;
+  if (sum > room || n > room - sum)
+    throw std::invalid_argument("Truncated record");
+  if (!well_formed(header, n ? load64(p + 8 * n) : 0))
+    throw std::invalid_argument("Malformed record");
+  return header;
+}
+
+size_t serialized_size(const Integer &x, const bool checksum) {
+  return record_bytes(header_of(x, checksum));
+}
+
+size_t serialize(const Integer &x, void *dst, const bool checksum) {
+  const VecU64 &v = x.view_v();
+  const size_t n = v.size();
+  const uint64_t header = header_of(x, checksum);
+  char *p = static_cast<char *>(dst);
+  store64(p, header);
+  if (LITTLE_ENDIAN_HOST) {
+    memcpy(p + 8, v.data(), 8 * n);
+  } else {
+    for (size_t i = 0; i < n; i++) store64(p + 8 * (i + 1), v[i]);
+  }
+  if (checksum) store64(p + 8 * (n + 1), checksum_of(header, v.data(), n));
+  return record_bytes(header);
+}
+
+void serialize(const Integer &x, std::string &out, const bool checksum) {
+  const size_t at = out.size();
+  out.resize(at + serialized_size(x, checksum));
+  serialize(x, &out[at], checksum);
+}
+
+void serialize(const Integer &x, std::ostream &os, const bool checksum) {
+  const VecU64 &v = x.view_v();
+  const size_t n = v.size();
+  const uint64_t header = header_of(x, checksum);
+  char word[8];
+  store64(word, header);
+  os.write(word, 8);
+  if (LITTLE_ENDIAN_HOST) {
+    os.write(reinterpret_cast<const char *>(v.data()),
+             static_cast<std::streamsize>(8 * n));
+  } else {
+    for (size_t i = 0; i < n; i++) {
+      store64(word, v[i]);
+      os.write(word, 8);
+    }
+  }
+  if (checksum) {
+    store64(word, checksum_of(header, v.data(), n));
+    os.write(word, 8);
+  }
+}
+
+size_t deserialize(const void *src, const size_t bytes, Integer &x) {
+  const char *p = static_cast<const char *>(src);
+  const uint64_t header = read_header(p, bytes);
+  const size_t n = size_of(header);
+
+  // aligned limbs on a little-endian host are used where they are
+  const bool direct =
+      LITTLE_ENDIAN_HOST && reinterpret_cast<uintptr_t>(p) % 8 == 0;
+  Scratch tmp(direct ? 0 : n);
+  const uint64_t *limbs = reinterpret_cast<const uint64_t *>(p) + 1;
+  if (!direct) {
+    for (size_t i = 0; i < n; i++) tmp.data()[i] = load64(p + 8 * (i + 1));
+    limbs = tmp.data();
+  }
+  if (has_checksum(header) &&
+      load64(p + 8 * (n + 1)) != checksum_of(header, limbs, n))
+    throw std::invalid_argument("Checksum mismatch");
+
+  x.abs_val_.assign(limbs, limbs + n);
+  x.neg_ = header & NEG;
+  return record_bytes(header);
+}
+
+std::istream &deserialize(std::istream &is, Integer &x) {
+  char word[8];
+  if (!is.read(word, 8)) return is;
+  const uint64_t header = load64(word);
+  const size_t n = size_of(header), words = n + has_checksum(header);
+
+  // in chunks, so a corrupt size runs into the end of the stream before it
+  // can take much memory
+  VecU64 v;
+  for (size_t have = 0; have < words;) {
+    const size_t chunk = std::min<size_t>(words - have, 1 << 16);
+    v.resize(have + chunk);
+    if (!is.read(reinterpret_cast<char *>(v.data() + have),
+                 static_cast<std::streamsize>(8 * chunk)))
+      return is;
+    have += chunk;
+  }
+  for (size_t i = 0; i < words; i++) v[i] = to_le(v[i]);
+  if (!well_formed(header, n ? v[n - 1] : 0) ||
+      (has_checksum(header) && v[n] != checksum_of(header, v.data(), n))) {
+    is.setstate(std::ios::failbit);
+    return is;
+  }
+
+  v.resize(n);
+  x.abs_val_ = std::move(v);
+  x.neg_ = header & NEG;
+  return is;
+}
+
+IntegerView::IntegerView(const void *src, const size_t bytes,
+                         const bool verify) {
+  if (!LITTLE_ENDIAN_HOST)
+    throw std::runtime_error("IntegerView needs a little-endian host");
+  const char *p = static_cast<const char *>(src);
+  if (reinterpret_cast<uintptr_t>(p) % 8)
+    throw std::invalid_argument("Misaligned record");
+
+  const uint64_t header = read_header(p, bytes);
+  limbs_ = reinterpret_cast<const uint64_t *>(p) + 1;
+  size_ = size_of(header);
+  neg_ = header & NEG;
+  checksum_ = has_checksum(header);
+  if (verify && checksum_ &&
+      limbs_[size_] != checksum_of(header, limbs_, size_))
+    throw std::invalid_argument("Checksum mismatch");
+}
+
+int IntegerView::cmp(const IntegerView &a, const Integer &b) {
+  if (a.neg_ != b.neg()) return a.neg_ ? -1 : 1;
+  const VecU64 &v = b.view_v();
+  int res;
+  if (a.size_ != v.size()) res = a.size_ > v.size() ? 1 : -1;
+  else res = cmp_n(a.limbs_, v.data(), a.size_);
+  return a.neg_ ? -res : res;
+}
+
+std::vector<IntegerView> view_records(const void *src, const size_t bytes,
+                                      const bool verify) {
+  std::vector<IntegerView> views;
+  const char *p = static_cast<const char *>(src);
+  for (size_t at = 0; at < bytes; at += views.back().bytes())
+    views.emplace_back(p + at, bytes - at, verify);
+  return views;
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+MappedFile::MappedFile(const std::string &path) : data_(nullptr), size_(0) {
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) throw std::runtime_error("Cannot open " + path);
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    throw std::runtime_error("Cannot stat " + path);
+  }
+
+  // an empty file maps to nothing
+  size_ = static_cast<size_t>(st.st_size);
+  if (size_) {
+    data_ = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data_ == MAP_FAILED) {
+      close(fd);
+      throw std::runtime_error("Cannot map " + path);
+    }
+  }
+  close(fd);
+}
+
+MappedFile::~MappedFile() {
+  if (data_) munmap(data_, size_);
+}
+#endif
+} // namespace lll
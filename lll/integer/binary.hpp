@@ -0,0 +1,92 @@
+#ifndef LLL_INTEGER_BINARY_HPP
+#define LLL_INTEGER_BINARY_HPP
+
+#include "../integer.hpp"
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace lll {
+// a binary record of one Integer, in little-endian 64-bit words:
+//
+//   checksum << 63 | size << 2 |      the header; size in limbs, no high
+//   checksum << 1 | neg               zero limbs, neg clear for 0
+//   limbs[size]                       the magnitude, low limb first
+//   checksum                          of the header and limbs, if the
+//                                     header says so
+//
+// 8 bytes per limb plus 8 or 16, against about 19.3 per limb in decimal,
+// and linear both ways. records are whole words: in a buffer aligned to 8
+// bytes, say a mapped file, every record's limbs are aligned too and can be
+// read in place (IntegerView). malformed records throw
+// std::invalid_argument.
+
+// bytes of the record of x
+size_t serialized_size(const Integer &x, bool checksum = false);
+// writes the record of x to dst, serialized_size(x, checksum) bytes;
+// returns that
+size_t serialize(const Integer &x, void *dst, bool checksum = false);
+// appends the record of x
+void serialize(const Integer &x, std::string &out, bool checksum = false);
+void serialize(const Integer &x, std::ostream &os, bool checksum = false);
+// x = the record at the start of src[0, bytes); returns its bytes
+size_t deserialize(const void *src, size_t bytes, Integer &x);
+// x = the next record of is; sets failbit and leaves x alone if there is
+// none or it is malformed
+std::istream &deserialize(std::istream &is, Integer &x);
+
+// a record read in place: nothing is copied, the limbs stay in the buffer,
+// which must outlive the view and be aligned to 8 bytes. limbs() is in the
+// form mpn takes. needs a little-endian host.
+class IntegerView {
+public:
+  IntegerView() : limbs_(nullptr), size_(0), neg_(false), checksum_(false) {}
+  // the record at the start of src[0, bytes); its checksum, if any, is
+  // checked unless verify is false
+  IntegerView(const void *src, size_t bytes, bool verify = true);
+
+  bool neg() const { return neg_; }
+  bool zero() const { return size_ == 0; }
+  size_t size() const { return size_; }
+  const uint64_t *limbs() const { return limbs_; }
+  // bytes of the record, header to checksum
+  size_t bytes() const { return 8 * (size_ + 1 + checksum_); }
+  Integer to_integer() const {
+    return Integer::from_limbs(limbs_, size_, neg_);
+  }
+
+  // 1: a > b; 0: a == b; -1: a < b
+  static int cmp(const IntegerView &a, const Integer &b);
+
+private:
+  const uint64_t *limbs_;
+  size_t size_;
+  bool neg_, checksum_;
+};
+
+// the records back to back in src[0, bytes), as written by serialize in a
+// row; only the views are allocated
+std::vector<IntegerView> view_records(const void *src, size_t bytes,
+                                      bool verify = true);
+
+#if defined(__unix__) || defined(__APPLE__)
+// a file mapped read-only, page aligned, for the views above. throws
+// std::runtime_error if it cannot be opened or mapped.
+class MappedFile {
+public:
+  explicit MappedFile(const std::string &path);
+  ~MappedFile();
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  const void *data() const { return data_; }
+  size_t size() const { return size_; }
+
+private:
+  void *data_;
+  size_t size_;
+};
+#endif
+} // namespace lll
+
+#endif // LLL_INTEGER_BINARY_HPP
@@ -1,18 +1,9 @@
 #include "internal.hpp"
+#include <algorithm>
 
 namespace lll {
 using namespace internal;
 
-static uint64_t ctz64(const uint64_t n) {
-#ifdef _MSC_VER
-  unsigned long res;
-  _BitScanForward64(&res, n);
-  return res;
-#elif defined(__GNUC__) || defined(__clang__)
-  return __builtin_ctzll(n);
-#endif
-}
-
 uint64_t Integer::pow_of_2() const {
   uint64_t i, res = 0;
   for (i = 0; i < abs_val_.size() && !abs_val_[i]; i++) res += 64;
@@ -30,12 +21,8 @@ static uint64_t shl64(const uint64_t n, const uint64_t s, uint64_t &carry) {
   return res;
 }
 
-static uint64_t shr64(const uint64_t n, const uint64_t s, uint64_t &carry) {
-  const uint64_t res = n >> s | carry;
-  carry = n << (64 - s);
-  return res;
-}
-
+// out may be a: the limbs move up from the top, and the top limb is known
+// beforehand, so the buffer grows at most once and only as far as needed.
 static void shl_abs_(const VecU64 &a, const uint64_t b, VecU64 &out) {
   if (a.empty()) {
     out.clear();
@@ -49,30 +36,21 @@ static void shl_abs_(const VecU64 &a, const uint64_t b, VecU64 &out) {
   const size_t size_a = a.size();
   const size_t shift_limb = b / 64;
   const size_t shift_bit = b % 64;
+  const uint64_t back = shift_bit ? a.back() >> (64 - shift_bit) : 0;
+  const size_t size_o = size_a + shift_limb + (back != 0);
 
   if (a.data() != out.data()) out.clear();
-  out.resize(size_a + shift_limb + 1);
+  out.resize(size_o);
 
+  uint64_t *r = out.data();
+  const uint64_t *p = a.data();
   if (shift_bit == 0) {
-    for (size_t i = size_a; i--;) out[i + shift_limb] = a[i];
-    out.pop_back();
+    std::copy_backward(p, p + size_a, r + shift_limb + size_a);
   } else {
-    //    limb          bit
-    // (a  <<  (Sl+1))  >>  (64 - Sb)
-    uint64_t carry = 0;
-    const uint64_t back = shr64(a.back(), 64 - shift_bit, carry);
-    if (back) {
-      out.back() = back;
-    } else {
-      out.pop_back();
-    }
-
-    for (size_t i = size_a; i--;) {
-      out[i + shift_limb] = shr64(a[i], 64 - shift_bit, carry);
-    }
+    lshift(r + shift_limb, p, size_a, shift_bit);
+    if (back) r[size_o - 1] = back;
   }
-
-  for (size_t i = shift_limb; i--;) out[i] = 0;
+  std::fill(r, r + shift_limb, 0);
 }
 
 static void shr_abs_(const VecU64 &a, const uint64_t b, VecU64 &out) {
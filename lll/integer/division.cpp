@@ -1,79 +1,69 @@
 #include "internal.hpp"
+#include "tuning.hpp"
+#include <algorithm>
 #include <stdexcept>
 
 namespace lll {
 using namespace internal;
 
-// quotient should be always 64-bits.
-static inline uint64_t div128(const uint64_t high, const uint64_t low,
-                              const uint64_t divisor, uint64_t &rem) {
-#if defined(_MSC_VER)
-  return _udiv128(high, low, divisor, &rem);
-#elif defined(__GNUC__) || defined(__clang__)
-  const __uint128_t dividend = (__uint128_t)high << 64 | (__uint128_t)low;
-  rem = dividend % divisor;
-  return dividend / divisor;
-#else
-
-#endif
+uint64_t internal::divrem_1_(uint64_t *q, const uint64_t *a, const size_t n,
+                             const uint64_t d) {
+  if (n == 1) {
+    const uint64_t x = a[0];
+    if (q) q[0] = x / d;
+    return x % d;
+  }
+  const uint64_t shift = clz64(d);
+  return divrem_1_preinv_(q, a, n, d << shift, shift, reciprocal64(d << shift));
+}
+
+uint64_t internal::divrem_1_preinv_(uint64_t *q, const uint64_t *a,
+                                    const size_t n, const uint64_t d,
+                                    const uint64_t shift, const uint64_t v) {
+  if (n == 0) return 0;
+  // a << shift one limb at a time, from the top. (x >> 1) >> (63 - shift)
+  // is x >> (64 - shift), but also defined for shift == 0.
+  uint64_t rem = (a[n - 1] >> 1) >> (63 - shift), digit;
+  for (size_t i = n - 1; i; i--) {
+    const uint64_t low = a[i] << shift | (a[i - 1] >> 1) >> (63 - shift);
+    digit = div_2by1(rem, low, d, v, rem);
+    if (q) q[i] = digit;
+  }
+  digit = div_2by1(rem, a[0] << shift, d, v, rem);
+  if (q) q[0] = digit;
+  return rem >> shift;
 }
 
 void internal::udiv_64bits_(const VecU64 &ddd, const uint64_t dsr, VecU64 &quot,
                             uint64_t &rem) {
   const size_t size = ddd.size();
-  rem = 0;
   quot.resize(size);
-  for (size_t i = size; i--;) {
-    quot[i] = div128(rem, ddd[i], dsr, rem);
-  }
+  rem = divrem_1_(quot.data(), ddd.data(), size, dsr);
   norm_top(quot);
 }
 
 static uint64_t umod_64bits_(const VecU64 &ddd, const uint64_t dsr) {
-  const size_t size = ddd.size();
-  uint64_t rem = 0;
-  for (size_t i = size; i--;) {
-    div128(rem, ddd[i], dsr, rem);
-  }
-  return rem;
-}
-
-static uint64_t
-shift_left(const VecU64 &src, VecU64 &dst, const uint64_t shift) {
-  uint64_t carry = 0;
-  for (size_t i = 0; i < src.size(); i++) {
-    const uint64_t curr = src[i];
-    dst[i] = curr << shift | carry;
-    carry = curr >> (64 - shift);
-  }
-  return carry;
+  return divrem_1_(nullptr, ddd.data(), ddd.size(), dsr);
 }
 
-static void shift_operands(const VecU64 &dividend, const VecU64 &divisor,
-                           VecU64 &ddd, VecU64 &dsr, const uint64_t shift) {
-  if (shift == 0) {
-    ddd = dividend;
-    dsr = divisor;
-    ddd.push_back(0);
-    return;
-  }
-
-  ddd.resize(dividend.size() + 1);
-  ddd.back() = shift_left(dividend, ddd, shift);
-
-  dsr.resize(divisor.size());
-  shift_left(divisor, dsr, shift);
-}
-
-static void div_lll_main(VecU64 &ddd, const VecU64 &dsr, VecU64 *quot) {
-  const size_t m = ddd.size();
-  const size_t n = dsr.size();
-
+// knuth's algorithm d. ddd has m limbs with its top limb below the top limb
+// of the normalized divisor dsr (n >= 2 limbs); leaves the remainder in the
+// low n limbs and writes the m - n quotient limbs to quot unless it is null.
+static void div_lll_main(uint64_t *ddd, const size_t m, const uint64_t *dsr,
+                         const size_t n, uint64_t *quot) {
   const uint64_t dsr_top1 = dsr[n - 1];
   const uint64_t dsr_top2 = dsr[n - 2];
+  const uint64_t v = reciprocal64(dsr_top1);
   uint64_t q_hat, r_hat, high, low;
   for (size_t i = m - n; i--;) {
-    q_hat = div128(ddd[i + n], ddd[i + n - 1], dsr_top1, r_hat);
+    if (ddd[i + n] == dsr_top1) {
+      // the digit is at most B - 1, which div_2by1 cannot return here
+      q_hat = UINT64_MAX;
+      r_hat = ddd[i + n - 1] + dsr_top1;
+      if (r_hat < dsr_top1) goto subtract; // r_hat >= B, q_hat stands
+    } else {
+      q_hat = div_2by1(ddd[i + n], ddd[i + n - 1], dsr_top1, v, r_hat);
+    }
 
   again:
     mul64(q_hat, dsr_top2, high, low);
@@ -85,86 +75,138 @@ static void div_lll_main(VecU64 &ddd, const VecU64 &dsr, VecU64 *quot) {
       if (r_hat >= dsr_top1) goto again;
     }
 
-    uint64_t borrow = 0;
-    for (size_t j = 0; j < n; j++) {
-      mul64(q_hat, dsr[j], high, low);
-      ddd[i + j] = sub64(ddd[i + j], low, borrow, borrow);
-      borrow += high;
-    }
-    ddd[i + n] -= borrow;
-
+  subtract:
+    ddd[i + n] -= submul_1(ddd + i, dsr, n, q_hat);
     if (ddd[i + n]) { // ddd[i + n] < 0
       q_hat -= 1;
-      uint64_t carry = 0;
-      for (size_t j = 0; j < n; j++) {
-        ddd[i + j] = add64(ddd[i + j], dsr[j], carry, carry);
-      }
-      ddd[i + n] += carry;
+      ddd[i + n] += add_n(ddd + i, ddd + i, dsr, n);
     }
-    if (quot) quot->at(i) = q_hat;
+    if (quot) quot[i] = q_hat;
   }
 }
 
-static void pop_rem_lll(VecU64 &ddd, VecU64 &rem, const uint64_t shift) {
-  norm(ddd);
-  if (shift == 0) {
-    rem = ddd;
-    return;
-  }
+// {np, nn} / {dp, dn}, d normalized, nn >= dn >= 2. writes the low nn - dn
+// quotient limbs to q and returns the one above them (0 or 1); leaves the
+// remainder in {np, dn}.
+static uint64_t div_school(uint64_t *q, uint64_t *np, const size_t nn,
+                           const uint64_t *dp, const size_t dn) {
+  uint64_t *top = np + nn - dn;
+  const uint64_t qh = cmp_n(top, dp, dn) >= 0;
+  if (qh) sub_n(top, top, dp, dn);
+  div_lll_main(np, nn, dp, dn, q);
+  return qh;
+}
 
-  const size_t size = ddd.size();
-  rem.resize(size);
+// burnikel-ziegler block: {np, dn + r} / {dp, dn} for r <= dn quotient
+// limbs, otherwise as div_school. a balanced block (r == dn) is two half
+// blocks. a short one divides its top 2r limbs by the top r limbs of d and
+// corrects with the low dn - r limbs of d, which is off by at most a few
+// multiples of d. t is dn limbs of scratch, s mul_itch(dn) more for umul_.
+static uint64_t div_block(uint64_t *q, uint64_t *np, const size_t r,
+                          const uint64_t *dp, const size_t dn, uint64_t *t,
+                          uint64_t *s) {
+  if (r < std::max<size_t>(tuning.div_dc, 2)) {
+    return div_school(q, np, dn + r, dp, dn);
+  }
+  if (r == dn) {
+    const size_t lo = r / 2, hi = r - lo;
+    const uint64_t qh = div_block(q + lo, np + lo, hi, dp, dn, t, s);
+    div_block(q, np, lo, dp, dn, t, s); // the top of its window is below d
+    return qh;
+  }
 
-  uint64_t carry = 0;
-  for (size_t i = size; i--;) {
-    const uint64_t curr = ddd[i];
-    rem[i] = curr >> shift | carry;
-    carry = curr << (64 - shift);
+  const size_t l = dn - r;
+  uint64_t qh = div_block(q, np + l, r, dp + l, r, t, s);
+  if (r >= l) umul_(t, q, r, dp, l, s);
+  else umul_(t, dp, l, q, r, s);
+  uint64_t borrow = sub_n(np, np, t, dn);
+  if (qh) borrow += sub_n(np + r, np + r, dp, l);
+  while (borrow) {
+    qh -= sub_1(q, r, 1);
+    borrow -= add_n(np, np, dp, dn);
   }
-  norm_top(rem);
+  return qh;
 }
 
-static void div_lll(const VecU64 &dividend, const VecU64 &divisor, VecU64 &quot,
-                    VecU64 *rem) {
-  const int cmp_res = ucmp(dividend, divisor);
-  if (cmp_res == 0) {
-    assign64(quot, 1);
-    if (rem) rem->clear();
+// div_lll_main through burnikel-ziegler blocks of n quotient limbs, from
+// the top, the first one short. tmp is m + mul_itch(n) limbs: a block's
+// product, the quotient if quot is null, and umul_'s scratch.
+static void div_dc(uint64_t *ddd, const size_t m, const uint64_t *dsr,
+                   const size_t n, uint64_t *quot, uint64_t *tmp) {
+  uint64_t *t = tmp, *q = quot ? quot : t + n, *s = t + m;
+  size_t done = m - n;
+  for (size_t r = done % n ? done % n : n; done; r = n) {
+    done -= r;
+    div_block(q + done, ddd + done, r, dsr, n, t, s);
   }
-  if (cmp_res < 0) {
-    assign64(quot, 0);
-    if (rem) *rem = dividend;
+}
+
+void internal::divrem_(uint64_t *q, uint64_t *r, const uint64_t *a,
+                       const size_t na, const uint64_t *d, const size_t nd,
+                       uint64_t *tmp) {
+  if (nd == 1) {
+    const uint64_t rem = divrem_1_(q, a, na, d[0]);
+    if (r) r[0] = rem;
     return;
   }
 
-  VecU64 ddd, dsr;
-  const uint64_t shift = clz64(divisor.back());
-  shift_operands(dividend, divisor, ddd, dsr, shift);
-
-  quot.resize(ddd.size() - dsr.size());
-  div_lll_main(ddd, dsr, &quot);
-  norm_top(quot);
+  // shift both operands so the divisor's top bit is set; the dividend gains
+  // a limb. both copies live in tmp, so q and r may alias the inputs.
+  uint64_t *ddd = tmp, *dsr = tmp + na + 1;
+  const uint64_t shift = clz64(d[nd - 1]);
+  if (shift) {
+    ddd[na] = lshift(ddd, a, na, shift);
+    lshift(dsr, d, nd, shift);
+  } else {
+    std::copy(a, a + na, ddd);
+    ddd[na] = 0;
+    std::copy(d, d + nd, dsr);
+  }
 
-  if (rem) pop_rem_lll(ddd, *rem, shift);
+  if (nd < tuning.div_dc || na + 1 - nd < tuning.div_dc) {
+    div_lll_main(ddd, na + 1, dsr, nd, q);
+  } else {
+    div_dc(ddd, na + 1, dsr, nd, q, dsr + nd);
+  }
+  if (!r) return;
+  if (shift) rshift(r, ddd, nd, shift);
+  else std::copy(ddd, ddd + nd, r);
 }
 
-static void mod_lll(const VecU64 &dividend, const VecU64 &divisor,
-                    VecU64 &rem) {
-  const int cmp_res = ucmp(dividend, divisor);
-  if (cmp_res == 0) {
-    rem.clear();
+// divrem_ copies both operands before it writes, so the quotient and the
+// remainder go straight into quot and rem, even when those are the operands.
+// they only grow until then, which keeps an operand among them intact.
+void internal::udiv_(const VecU64 &dividend, const VecU64 &divisor,
+                     VecU64 &quot, VecU64 *rem) {
+  const size_t na = dividend.size(), nd = divisor.size();
+  if (na < nd) {
+    if (rem) *rem = dividend;
+    quot.clear();
     return;
   }
-  if (cmp_res < 0) {
+
+  const size_t nq = na - nd + 1;
+  if (quot.size() < nq) quot.resize(nq);
+  if (rem && rem->size() < nd) rem->resize(nd);
+  Scratch tmp(divrem_itch(na, nd));
+  divrem_(quot.data(), rem ? rem->data() : nullptr, dividend.data(), na,
+          divisor.data(), nd, tmp.data());
+  if (rem) rem->resize(norm_size(rem->data(), nd));
+  quot.resize(norm_size(quot.data(), nq));
+}
+
+static void umod_(const VecU64 &dividend, const VecU64 &divisor, VecU64 &rem) {
+  const size_t na = dividend.size(), nd = divisor.size();
+  if (na < nd) {
     rem = dividend;
     return;
   }
 
-  VecU64 ddd, dsr;
-  const uint64_t shift = clz64(divisor.back());
-  shift_operands(dividend, divisor, ddd, dsr, shift);
-  div_lll_main(ddd, dsr, nullptr);
-  pop_rem_lll(ddd, rem, shift);
+  if (rem.size() < nd) rem.resize(nd);
+  Scratch tmp(divrem_itch(na, nd));
+  divrem_(nullptr, rem.data(), dividend.data(), na, divisor.data(), nd,
+          tmp.data());
+  rem.resize(norm_size(rem.data(), nd));
 }
 
 void Integer::div_64bits(const Integer &a, const int64_t b, Integer &quot,
@@ -172,29 +214,23 @@ void Integer::div_64bits(const Integer &a, const int64_t b, Integer &quot,
   if (b == 0) throw std::domain_error("Division by zero");
 
   uint64_t rem_u;
+  const bool neg_a = a.neg_;
   udiv_64bits_(a.abs_val_, abs64(b), quot.abs_val_, rem_u);
 
-  quot.neg_ = !quot.zero() && a.neg_ ^ (b < 0);
-  if (rem) *rem = static_cast<int64_t>(a.neg_ ? -rem_u : rem_u);
+  quot.neg_ = !quot.zero() && neg_a ^ (b < 0);
+  if (rem) *rem = static_cast<int64_t>(neg_a ? -rem_u : rem_u);
 }
 
 void Integer::div(const Integer &a, const Integer &b, Integer &quot,
                   Integer *rem) {
   if (b.zero()) throw std::domain_error("Division by zero");
+  if (rem == &quot) rem = nullptr;
 
-  const VecU64 &dividend = a.abs_val_;
-  const VecU64 &divisor = b.abs_val_;
-
-  if (divisor.size() == 1) {
-    uint64_t rem_64bits;
-    udiv_64bits_(dividend, divisor[0], quot.abs_val_, rem_64bits);
-    if (rem) assign64(rem->abs_val_, rem_64bits);
-  } else {
-    div_lll(dividend, divisor, quot.abs_val_, rem ? &rem->abs_val_ : nullptr);
-  }
-
-  quot.neg_ = !quot.zero() && a.neg_ ^ b.neg_;
-  if (rem) rem->neg_ = !rem->zero() && a.neg_;
+  // the signs first: quot and rem may be a and b
+  const bool neg_a = a.neg_, neg_q = a.neg_ ^ b.neg_;
+  udiv_(a.abs_val_, b.abs_val_, quot.abs_val_, rem ? &rem->abs_val_ : nullptr);
+  quot.neg_ = !quot.zero() && neg_q;
+  if (rem) rem->neg_ = !rem->zero() && neg_a;
 }
 
 void Integer::mod_64bits(const Integer &a, const int64_t b, int64_t &out) {
@@ -214,7 +250,7 @@ void Integer::mod(const Integer &a, const Integer &b, Integer &out) {
     const uint64_t rem_64bits = umod_64bits_(dividend, divisor[0]);
     assign64(out.abs_val_, rem_64bits);
   } else {
-    mod_lll(dividend, divisor, out.abs_val_);
+    umod_(dividend, divisor, out.abs_val_);
   }
 
   out.neg_ = !out.zero() && a.neg_;
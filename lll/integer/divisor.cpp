@@ -0,0 +1,127 @@
+#include "divisor.hpp"
+#include "internal.hpp"
+#include "tuning.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace lll {
+using namespace internal;
+
+Divisor::Divisor(const Integer &d) : d_(d) {
+  if (d.zero()) throw std::domain_error("Division by zero");
+  const size_t n = d.abs_val_.size();
+  if (n < std::max<size_t>(tuning.div_reciprocal, 2)) return;
+
+  VecU64 num(2 * n + 1, 0);
+  num.back() = 1;
+  udiv_(num, d.abs_val_, mu_.abs_val_, nullptr);
+}
+
+// x[0, 2n) < d * B^n: q[0, n) = x / d, x[0, n) = x % d. t is 4n + 3 limbs.
+// the estimate floor(floor(x / B^(n-1)) * mu / B^(n+1)) is at most two
+// below the quotient.
+static void barrett_step(uint64_t *q, uint64_t *x, const uint64_t *d,
+                         const size_t n, const uint64_t *mu, const size_t nm,
+                         uint64_t *t) {
+  const uint64_t *x1 = x + n - 1;
+  const size_t nx1 = norm_size(x1, n + 1);
+  std::fill(t, t + 2 * n + 3, 0);
+  if (nx1 >= nm) umul_(t, x1, nx1, mu, nm);
+  else if (nx1) umul_(t, mu, nm, x1, nx1);
+  std::copy(t + n + 1, t + 2 * n + 1, q);
+
+  // the remainder is below 3d, so n + 1 limbs of x - q * d suffice
+  const size_t nq = norm_size(q, n);
+  uint64_t *p = t + 2 * n + 3;
+  if (nq) {
+    umul_(p, d, n, q, nq);
+    sub_n(x, x, p, n + 1);
+  }
+  while (x[n] || cmp_n(x, d, n) >= 0) {
+    x[n] -= sub_n(x, x, d, n);
+    add_1(q, n, 1);
+  }
+}
+
+void Divisor::divide(const VecU64 &a, VecU64 *quot, VecU64 *rem) const {
+  const VecU64 &dv = d_.abs_val_;
+  const size_t n = dv.size(), na = a.size();
+  if (na < n) {
+    if (rem) *rem = a;
+    if (quot) quot->clear();
+    return;
+  }
+
+  // n limbs of a at a time from the top, the first chunk short
+  const size_t first = na % n ? na % n : n;
+  size_t pos = na - first;
+  Scratch tmp(2 * n + pos + 1 + n + 4 * n + 3);
+  uint64_t *x = tmp.data(), *q = x + 2 * n, *qq = q + pos + 1, *t = qq + n;
+  const uint64_t *mu = mu_.abs_val_.data();
+  const size_t nm = mu_.abs_val_.size();
+
+  std::fill(x, x + 2 * n, 0);
+  std::copy(a.data() + pos, a.data() + na, x);
+  barrett_step(qq, x, dv.data(), n, mu, nm, t);
+  q[pos] = qq[0]; // x < B^n, so the quotient is below B
+  while (pos) {
+    pos -= n;
+    std::copy(x, x + n, x + n);
+    std::copy(a.data() + pos, a.data() + pos + n, x);
+    barrett_step(q + pos, x, dv.data(), n, mu, nm, t);
+  }
+
+  if (rem) rem->assign(x, x + norm_size(x, n));
+  if (quot) quot->assign(q, q + norm_size(q, na - first + 1));
+}
+
+void Divisor::div(const Integer &a, Integer &quot, Integer *rem) const {
+  if (mu_.zero()) {
+    Integer::div(a, d_, quot, rem);
+    return;
+  }
+
+  const bool neg = a.neg_;
+  divide(a.abs_val_, &quot.abs_val_, rem ? &rem->abs_val_ : nullptr);
+  quot.neg_ = !quot.zero() && neg ^ d_.neg_;
+  if (rem) rem->neg_ = !rem->zero() && neg;
+}
+
+Integer Divisor::mod(const Integer &a) const {
+  Integer out;
+  if (mu_.zero()) {
+    Integer::mod(a, d_, out);
+    return out;
+  }
+
+  divide(a.abs_val_, nullptr, &out.abs_val_);
+  out.neg_ = !out.zero() && a.neg_;
+  return out;
+}
+
+Divisor64::Divisor64(const uint64_t d) {
+  if (d == 0) throw std::domain_error("Division by zero");
+  shift_ = clz64(d);
+  d_ = d << shift_;
+  v_ = reciprocal64(d_);
+}
+
+uint64_t Divisor64::divrem(uint64_t *q, const uint64_t *a,
+                           const size_t n) const {
+  return divrem_1_preinv_(q, a, n, d_, shift_, v_);
+}
+
+uint64_t Divisor64::div(const Integer &a, Integer &quot) const {
+  const bool neg = a.neg_;
+  const size_t size = a.abs_val_.size();
+  quot.abs_val_.resize(size);
+  const uint64_t rem = divrem(quot.abs_val_.data(), a.abs_val_.data(), size);
+  norm_top(quot.abs_val_);
+  quot.neg_ = !quot.zero() && neg;
+  return rem;
+}
+
+uint64_t Divisor64::mod(const Integer &a) const {
+  return divrem(nullptr, a.abs_val_.data(), a.abs_val_.size());
+}
+} // namespace lll
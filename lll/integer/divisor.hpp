@@ -0,0 +1,55 @@
+#ifndef LLL_INTEGER_DIVISOR_HPP
+#define LLL_INTEGER_DIVISOR_HPP
+
+#include "../integer.hpp"
+
+namespace lll {
+// division by a fixed d != 0 with its reciprocal mu = floor(B^(2n) / d),
+// B = 2^64 and n the limbs of d, computed once. every n limbs of a dividend
+// then cost two multiplications (barrett) instead of a recursive division.
+// that wins from tuning.div_reciprocal limbs; smaller divisors go straight
+// to Integer::div.
+class Divisor {
+public:
+  explicit Divisor(const Integer &d);
+
+  const Integer &value() const { return d_; }
+
+  // quot = a / d, rem = a % d, with the signs of Integer::div
+  void div(const Integer &a, Integer &quot, Integer *rem = nullptr) const;
+  // a % d, with the sign of Integer::mod
+  Integer mod(const Integer &a) const;
+
+private:
+  void divide(const Integer::VecView &a, Integer::VecView *quot,
+              Integer::VecView *rem) const;
+
+  Integer d_;
+  Integer mu_; // zero below tuning.div_reciprocal limbs
+};
+
+// division by a fixed word d != 0 through its moller-granlund reciprocal,
+// computed once: every limb of a dividend then costs a multiply instead of
+// a hardware divide.
+class Divisor64 {
+public:
+  explicit Divisor64(uint64_t d);
+
+  uint64_t value() const { return d_ >> shift_; }
+
+  // quot = a / d, truncated like Integer::div; returns |a| % d, the
+  // remainder carrying the sign of a
+  uint64_t div(const Integer &a, Integer &quot) const;
+  // |a| % d
+  uint64_t mod(const Integer &a) const;
+  // q[0, n) = a / d over raw limbs, returns a % d. q may be a, or null.
+  uint64_t divrem(uint64_t *q, const uint64_t *a, size_t n) const;
+
+private:
+  uint64_t d_; // d << shift_, top bit set
+  uint64_t shift_;
+  uint64_t v_; // reciprocal of d_
+};
+} // namespace lll
+
+#endif // LLL_INTEGER_DIVISOR_HPP
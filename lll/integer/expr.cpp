@@ -0,0 +1,145 @@
+#include "internal.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace lll {
+using namespace internal;
+
+// |a * b + c| for a product of sign neg_p and c of sign neg_c, built in one
+// buffer: the product, then c added or subtracted in place. returns the
+// sign. out may be any of the operands.
+static bool muladd_(const VecU64 &a, const VecU64 &b, const bool neg_p,
+                    const VecU64 &c, const bool neg_c, VecU64 &out) {
+  if (a.empty() || b.empty()) {
+    if (&out != &c) out = c;
+    return !c.empty() && neg_c;
+  }
+
+  const VecU64 &max = a.size() >= b.size() ? a : b;
+  const VecU64 &min = &max == &a ? b : a;
+  const size_t np = a.size() + b.size(), nc = c.size();
+  const size_t n = std::max(np, nc) + 1;
+
+  // straight into out's buffer, unless that holds an operand
+  const bool alias = &out == &a || &out == &b || &out == &c;
+  Scratch tmp(alias ? n : 0);
+  if (!alias) out.resize(n);
+  uint64_t *r = alias ? tmp.data() : out.data();
+
+  umul_(r, max.data(), max.size(), min.data(), min.size());
+  std::fill(r + np, r + n, 0);
+  bool neg = neg_p;
+  if (neg_p == neg_c) {
+    add_1(r + nc, n - nc, add_n(r, r, c.data(), nc));
+  } else {
+    const size_t m = norm_size(r, np);
+    if (m > nc || (m == nc && cmp_n(r, c.data(), nc) >= 0)) {
+      sub_1(r + nc, n - nc, sub_n(r, r, c.data(), nc));
+    } else {
+      const uint64_t borrow = sub_n(r, c.data(), r, m);
+      std::copy(c.data() + m, c.data() + nc, r + m);
+      sub_1(r + m, nc - m, borrow);
+      neg = neg_c;
+    }
+  }
+
+  const size_t size = norm_size(r, n);
+  if (alias) out.assign(r, r + size);
+  else out.resize(size);
+  return size != 0 && neg;
+}
+
+void Integer::addmul(const Integer &a, const Integer &b, const Integer &c,
+                     Integer &out) {
+  out.neg_ = muladd_(a.abs_val_, b.abs_val_, a.neg_ ^ b.neg_, c.abs_val_,
+                     c.neg_, out.abs_val_);
+}
+
+void Integer::submul(const Integer &a, const Integer &b, const Integer &c,
+                     Integer &out) {
+  out.neg_ = muladd_(a.abs_val_, b.abs_val_, a.neg_ ^ b.neg_, c.abs_val_,
+                     !c.neg_, out.abs_val_);
+}
+
+void Integer::mulmod(const Integer &a, const Integer &b, const Integer &m,
+                     Integer &out) {
+  if (m.zero()) throw std::domain_error("Division by zero");
+  if (a.zero() || b.zero()) {
+    out = 0;
+    return;
+  }
+
+  // the product stays in scratch and only the remainder reaches out
+  const VecU64 &max = a.abs_val_.size() >= b.abs_val_.size() ? a.abs_val_
+                                                              : b.abs_val_;
+  const VecU64 &min = &max == &a.abs_val_ ? b.abs_val_ : a.abs_val_;
+  const VecU64 &d = m.abs_val_;
+  const size_t np = max.size() + min.size(), nd = d.size();
+  const bool neg = a.neg_ ^ b.neg_;
+
+  Scratch tmp(np + nd + divrem_itch(np, nd));
+  uint64_t *p = tmp.data(), *r = p + np;
+  umul_(p, max.data(), max.size(), min.data(), min.size());
+  const size_t n = norm_size(p, np);
+  if (nd == 1) {
+    assign64(out.abs_val_, divrem_1_(nullptr, p, n, d[0]));
+  } else if (n < nd) {
+    out.abs_val_.assign(p, p + n);
+  } else {
+    divrem_(nullptr, r, p, n, d.data(), nd, r + nd);
+    out.abs_val_.assign(r, r + norm_size(r, nd));
+  }
+  out.neg_ = !out.zero() && neg;
+}
+
+// out = (a + b) >> s on magnitudes: the limbs of the sum from s / 64 up go
+// straight into out and shift there; the ones below only pass on a carry.
+// out must not be a or b.
+static void add_shr_(const VecU64 &a, const VecU64 &b, const uint64_t s,
+                     VecU64 &out) {
+  const VecU64 &max = a.size() >= b.size() ? a : b;
+  const VecU64 &min = &max == &a ? b : a;
+  const size_t k = s / 64;
+  if (k > max.size()) {
+    out.clear();
+    return;
+  }
+
+  uint64_t low = 0;
+  for (size_t i = 0; i < k; i++) {
+    add64(max[i], i < min.size() ? min[i] : 0, low, low);
+  }
+
+  const size_t nx = max.size() - k, nm = min.size() > k ? min.size() - k : 0;
+  out.resize(nx + 1);
+  uint64_t *r = out.data();
+  uint64_t carry = add_n(r, max.data() + k, min.data() + k, nm);
+  std::copy(max.data() + k + nm, max.data() + max.size(), r + nm);
+  carry = add_1(r + nm, nx - nm, carry);
+  r[nx] = carry + add_1(r, nx, low);
+  if (s % 64) rshift(r, r, nx + 1, s % 64);
+  norm(out);
+}
+
+void Integer::add_shr(const Integer &a, const Integer &b, const uint64_t s,
+                      Integer &out) {
+  if (a.neg_ != b.neg_ || &out == &a || &out == &b) {
+    add(a, b, out);
+    shr_abs(out, s, out);
+    return;
+  }
+  add_shr_(a.abs_val_, b.abs_val_, s, out.abs_val_);
+  out.neg_ = !out.zero() && a.neg_;
+}
+
+void Integer::sub_shr(const Integer &a, const Integer &b, const uint64_t s,
+                      Integer &out) {
+  if (a.neg_ == b.neg_ || &out == &a || &out == &b) {
+    sub(a, b, out);
+    shr_abs(out, s, out);
+    return;
+  }
+  add_shr_(a.abs_val_, b.abs_val_, s, out.abs_val_);
+  out.neg_ = !out.zero() && a.neg_;
+}
+} // namespace lll
@@ -0,0 +1,30 @@
+#ifndef LLL_INTEGER_EXPR_HPP
+#define LLL_INTEGER_EXPR_HPP
+
+#include "../integer.hpp"
+
+namespace lll {
+// a * b held by reference, for y += product(a, b) and y -= product(a, b):
+// the product is added to or taken from y in y's buffer, with no Integer
+// in between (Integer::addmul / submul). a * b itself is an Integer; the
+// other fused forms are the statics addmul, submul, mulmod, add_shr and
+// sub_shr. a MulExpr must not outlive a and b.
+struct MulExpr {
+  const Integer &a, &b;
+};
+
+inline MulExpr product(const Integer &a, const Integer &b) { return {a, b}; }
+
+inline Integer &Integer::operator+=(const MulExpr &e) {
+  addmul(e.a, e.b, *this, *this);
+  return *this;
+}
+
+inline Integer &Integer::operator-=(const MulExpr &e) {
+  submul(e.a, e.b, *this, *this);
+  opp(*this, *this);
+  return *this;
+}
+} // namespace lll
+
+#endif // LLL_INTEGER_EXPR_HPP
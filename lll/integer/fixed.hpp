@@ -0,0 +1,317 @@
+#ifndef LLL_INTEGER_FIXED_HPP
+#define LLL_INTEGER_FIXED_HPP
+
+#include "../integer.hpp"
+#include "word.hpp"
+#include <stdexcept>
+
+namespace lll {
+// an unsigned integer of exactly Limbs 64-bit limbs, little-endian, with
+// arithmetic wrapping mod 2^(64 * Limbs): for values that are always 128,
+// 256 or 512 bits. there is no size to track or normalize and no heap; the
+// loops all run to the constant Limbs, so the compiler unrolls them and a
+// value can live in registers.
+template <size_t Limbs> class FixedInteger {
+  static_assert(Limbs > 0, "FixedInteger needs at least one limb.");
+
+public:
+  static constexpr size_t BITS = 64 * Limbs;
+
+  constexpr FixedInteger() : limbs_{} {}
+
+  constexpr FixedInteger(const uint64_t value) // NOLINT(*-explicit-constructor)
+    : limbs_{value} {}
+
+  // x mod 2^BITS; negative x wrap around (two's complement)
+  explicit FixedInteger(const Integer &x) : limbs_{} {
+    const Integer::VecView &v = x.view_v();
+    for (size_t i = 0; i < Limbs && i < v.size(); i++) limbs_[i] = v[i];
+    if (x.neg()) *this = -*this;
+  }
+
+  Integer to_integer() const { return Integer::from_limbs(limbs_, Limbs); }
+
+  constexpr uint64_t operator[](const size_t i) const { return limbs_[i]; }
+  uint64_t &operator[](const size_t i) { return limbs_[i]; }
+  const uint64_t *data() const { return limbs_; }
+  uint64_t *data() { return limbs_; }
+
+  bool zero() const {
+    uint64_t any = 0;
+    for (size_t i = 0; i < Limbs; i++) any |= limbs_[i];
+    return any == 0;
+  }
+
+  // bits of the value, 0 for 0
+  size_t bit_size() const {
+    for (size_t i = Limbs; i--;) {
+      if (limbs_[i]) return 64 * (i + 1) - internal::clz64(limbs_[i]);
+    }
+    return 0;
+  }
+
+  static int cmp(const FixedInteger &a, const FixedInteger &b) {
+    for (size_t i = Limbs; i--;) {
+      if (a.limbs_[i] != b.limbs_[i]) return a.limbs_[i] < b.limbs_[i] ? -1 : 1;
+    }
+    return 0;
+  }
+
+  // out = a + b, returns the carry out of the top limb
+  static uint64_t add(const FixedInteger &a, const FixedInteger &b,
+                      FixedInteger &out) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < Limbs; i++)
+      out.limbs_[i] = internal::add64(a.limbs_[i], b.limbs_[i], carry, carry);
+    return carry;
+  }
+
+  // out = a - b, returns the borrow out of the top limb
+  static uint64_t sub(const FixedInteger &a, const FixedInteger &b,
+                      FixedInteger &out) {
+    uint64_t borrow = 0;
+    for (size_t i = 0; i < Limbs; i++)
+      out.limbs_[i] = internal::sub64(a.limbs_[i], b.limbs_[i], borrow, borrow);
+    return borrow;
+  }
+
+  // out = a * b mod 2^BITS; out may be a or b
+  static void mul(const FixedInteger &a, const FixedInteger &b,
+                  FixedInteger &out) {
+    FixedInteger r;
+    for (size_t i = 0; i < Limbs; i++) {
+      uint64_t carry = 0;
+      for (size_t j = 0; i + j < Limbs; j++) {
+        uint64_t high, low, c;
+        internal::mul64(a.limbs_[i], b.limbs_[j], high, low);
+        r.limbs_[i + j] = internal::add64(r.limbs_[i + j], low, carry, c);
+        carry = high + c;
+      }
+    }
+    out = r;
+  }
+
+  // the whole product, of Limbs + M limbs
+  template <size_t M>
+  FixedInteger<Limbs + M> mul_wide(const FixedInteger<M> &b) const {
+    FixedInteger<Limbs + M> r;
+    uint64_t *p = r.data();
+    for (size_t j = 0; j < M; j++)
+      p[j + Limbs] = addmul_row(p + j, limbs_, Limbs, b[j]);
+    return r;
+  }
+
+  // quot = a / b, rem = a % b; either may be a or b
+  static void divmod(const FixedInteger &a, const FixedInteger &b,
+                     FixedInteger &quot, FixedInteger &rem) {
+    size_t n = Limbs;
+    while (n && b.limbs_[n - 1] == 0) n--;
+    if (n == 0) throw std::domain_error("Division by zero");
+
+    // knuth's algorithm d on copies shifted so the top bit of b is set
+    const unsigned s = (unsigned)internal::clz64(b.limbs_[n - 1]);
+    uint64_t u[Limbs + 1], v[Limbs];
+    shl_limbs(u, a.limbs_, Limbs, s);
+    u[Limbs] = s ? a.limbs_[Limbs - 1] >> (64 - s) : 0;
+    shl_limbs(v, b.limbs_, n, s);
+
+    const uint64_t top = v[n - 1], inv = internal::reciprocal64(top);
+    FixedInteger q;
+    for (size_t j = Limbs - n + 1; j--;) {
+      uint64_t qhat, rhat;
+      bool over = false; // rhat >= 2^64: the estimate is exact
+      if (u[j + n] >= top) {
+        qhat = UINT64_MAX;
+        rhat = u[j + n - 1] + top;
+        over = rhat < top;
+      } else {
+        qhat = internal::div_2by1(u[j + n], u[j + n - 1], top, inv, rhat);
+      }
+      while (n > 1 && !over) {
+        uint64_t high, low;
+        internal::mul64(qhat, v[n - 2], high, low);
+        if (high < rhat || (high == rhat && low <= u[j + n - 2])) break;
+        qhat--;
+        rhat += top;
+        over = rhat < top;
+      }
+
+      const uint64_t borrow = submul_row(u + j, v, n, qhat);
+      if (u[j + n] < borrow) { // one too large, rarely
+        qhat--;
+        add_row(u + j, v, n);
+      }
+      u[j + n] = 0;
+      q.limbs_[j] = qhat;
+    }
+
+    // the remainder is u[0, n) shifted back
+    quot = q;
+    for (size_t i = 0; i < Limbs; i++) {
+      uint64_t x = 0;
+      if (i < n) x = u[i] >> s;
+      if (s && i + 1 < n) x |= u[i + 1] << (64 - s);
+      rem.limbs_[i] = x;
+    }
+  }
+
+  FixedInteger operator-() const {
+    FixedInteger r;
+    sub(FixedInteger(), *this, r);
+    return r;
+  }
+
+  FixedInteger &operator+=(const FixedInteger &other) {
+    add(*this, other, *this);
+    return *this;
+  }
+
+  FixedInteger &operator-=(const FixedInteger &other) {
+    sub(*this, other, *this);
+    return *this;
+  }
+
+  FixedInteger &operator*=(const FixedInteger &other) {
+    mul(*this, other, *this);
+    return *this;
+  }
+
+  FixedInteger &operator/=(const FixedInteger &other) {
+    FixedInteger rem;
+    divmod(*this, other, *this, rem);
+    return *this;
+  }
+
+  FixedInteger &operator%=(const FixedInteger &other) {
+    FixedInteger quot;
+    divmod(*this, other, quot, *this);
+    return *this;
+  }
+
+  // shifts by BITS or more give 0
+  FixedInteger &operator<<=(const size_t bits) {
+    const size_t k = bits / 64;
+    const unsigned s = bits % 64;
+    for (size_t i = Limbs; i--;) {
+      uint64_t x = 0;
+      if (i >= k) x = limbs_[i - k] << s;
+      if (s && i >= k + 1) x |= limbs_[i - k - 1] >> (64 - s);
+      limbs_[i] = x;
+    }
+    return *this;
+  }
+
+  FixedInteger &operator>>=(const size_t bits) {
+    const size_t k = bits / 64;
+    const unsigned s = bits % 64;
+    for (size_t i = 0; i < Limbs; i++) {
+      uint64_t x = 0;
+      if (i + k < Limbs) x = limbs_[i + k] >> s;
+      if (s && i + k + 1 < Limbs) x |= limbs_[i + k + 1] << (64 - s);
+      limbs_[i] = x;
+    }
+    return *this;
+  }
+
+  friend FixedInteger operator+(FixedInteger a, const FixedInteger &b) {
+    return a += b;
+  }
+
+  friend FixedInteger operator-(FixedInteger a, const FixedInteger &b) {
+    return a -= b;
+  }
+
+  friend FixedInteger operator*(FixedInteger a, const FixedInteger &b) {
+    return a *= b;
+  }
+
+  friend FixedInteger operator/(FixedInteger a, const FixedInteger &b) {
+    return a /= b;
+  }
+
+  friend FixedInteger operator%(FixedInteger a, const FixedInteger &b) {
+    return a %= b;
+  }
+
+  friend FixedInteger operator<<(FixedInteger a, const size_t bits) {
+    return a <<= bits;
+  }
+
+  friend FixedInteger operator>>(FixedInteger a, const size_t bits) {
+    return a >>= bits;
+  }
+
+  friend bool operator==(const FixedInteger &a, const FixedInteger &b) {
+    return cmp(a, b) == 0;
+  }
+
+  friend bool operator!=(const FixedInteger &a, const FixedInteger &b) {
+    return cmp(a, b) != 0;
+  }
+
+  friend bool operator<(const FixedInteger &a, const FixedInteger &b) {
+    return cmp(a, b) < 0;
+  }
+
+  friend bool operator>(const FixedInteger &a, const FixedInteger &b) {
+    return cmp(a, b) > 0;
+  }
+
+  friend bool operator<=(const FixedInteger &a, const FixedInteger &b) {
+    return cmp(a, b) <= 0;
+  }
+
+  friend bool operator>=(const FixedInteger &a, const FixedInteger &b) {
+    return cmp(a, b) >= 0;
+  }
+
+private:
+  // r[0, n) = a[0, n) << s, s < 64, dropping the bits shifted out
+  static void shl_limbs(uint64_t *r, const uint64_t *a, const size_t n,
+                        const unsigned s) {
+    for (size_t i = n; i--;)
+      r[i] = s ? a[i] << s | (i ? a[i - 1] >> (64 - s) : 0) : a[i];
+  }
+
+  // r[0, n) += a[0, n) * b, returning the high limb
+  static uint64_t addmul_row(uint64_t *r, const uint64_t *a, const size_t n,
+                             const uint64_t b) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < n; i++) {
+      uint64_t high, low, c;
+      internal::mul64(a[i], b, high, low);
+      r[i] = internal::add64(r[i], low, carry, c);
+      carry = high + c;
+    }
+    return carry;
+  }
+
+  // r[0, n) -= a[0, n) * b, returning the borrow out of the top
+  static uint64_t submul_row(uint64_t *r, const uint64_t *a, const size_t n,
+                             const uint64_t b) {
+    uint64_t borrow = 0;
+    for (size_t i = 0; i < n; i++) {
+      uint64_t high, low, c;
+      internal::mul64(a[i], b, high, low);
+      r[i] = internal::sub64(r[i], low, borrow, c);
+      borrow = high + c;
+    }
+    return borrow;
+  }
+
+  // r[0, n) += a[0, n), dropping the carry out
+  static void add_row(uint64_t *r, const uint64_t *a, const size_t n) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < n; i++)
+      r[i] = internal::add64(r[i], a[i], carry, carry);
+  }
+
+  uint64_t limbs_[Limbs];
+};
+
+using UInt128 = FixedInteger<2>;
+using UInt256 = FixedInteger<4>;
+using UInt512 = FixedInteger<8>;
+} // namespace lll
+
+#endif // LLL_INTEGER_FIXED_HPP
@@ -0,0 +1,555 @@
+#include "internal.hpp"
+#include "math.hpp"
+#include "tuning.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace lll {
+using namespace internal;
+
+static uint64_t gcd64(uint64_t a, uint64_t b) {
+  if (a == 0) return b;
+  if (b == 0) return a;
+
+  const uint64_t k = ctz64(a | b);
+  a >>= ctz64(a);
+  while (b) {
+    b >>= ctz64(b);
+    if (a > b) std::swap(a, b);
+    b -= a;
+  }
+  return a << k;
+}
+
+// x[0, n) >>= its trailing zero bits, x != 0; returns their count
+static uint64_t strip_zeros(uint64_t *x, const size_t n) {
+  size_t z = 0;
+  while (x[z] == 0) z++;
+  const uint64_t s = ctz64(x[z]);
+  std::copy(x + z, x + n, x);
+  std::fill(x + n - z, x + n, 0);
+  if (s) rshift(x, x, n - z, s);
+  return 64 * z + s;
+}
+
+// binary gcd of a odd and b != 0, n limbs each: strip the low zero bits of
+// b, subtract the smaller value from the larger, repeat. the result is left
+// in a or b; returns it and its size.
+static uint64_t *binary_gcd(uint64_t *a, uint64_t *b, const size_t n,
+                            size_t &size) {
+  size_t na = norm_size(a, n), nb = norm_size(b, n);
+  while (true) {
+    strip_zeros(b, nb);
+    nb = norm_size(b, nb);
+    if (na == 1 && nb == 1) {
+      a[0] = gcd64(a[0], b[0]);
+      size = 1;
+      return a;
+    }
+
+    const int c = na != nb ? (na > nb ? 1 : -1) : cmp_n(a, b, na);
+    if (c == 0) {
+      size = na;
+      return a;
+    }
+    if (c > 0) {
+      std::swap(a, b);
+      std::swap(na, nb);
+    }
+    sub_1(b + na, nb - na, sub_n(b, b, a, na));
+    nb = norm_size(b, nb);
+  }
+}
+
+// 64 bits of x[0, n) from bit p on, zero past the top
+static uint64_t bits_at(const uint64_t *x, const size_t n, const uint64_t p) {
+  const size_t i = p / 64;
+  const uint64_t s = p % 64;
+  const uint64_t low = i < n ? x[i] >> s : 0;
+  return s && i + 1 < n ? low | x[i + 1] << (64 - s) : low;
+}
+
+// (ah, al) %= (bh, bl) for 128-bit a >= b > 0, q the quotient; false,
+// leaving a alone, if q does not fit in 64 bits.
+static bool divstep128(uint64_t &ah, uint64_t &al, const uint64_t bh,
+                       const uint64_t bl, uint64_t &q) {
+  if (bh == 0) {
+    if (ah >= bl) return false;
+    q = div128(ah, al, bl, al);
+    ah = 0;
+    return true;
+  }
+
+  // the top limb of b normalized into the estimate, which is at most two
+  // above q (knuth's theorem b)
+  const uint64_t s = clz64(bh);
+  const uint64_t top = s ? bh << s | bl >> (64 - s) : bh;
+  const uint64_t a2 = s ? ah >> (64 - s) : 0;
+  const uint64_t a1 = s ? ah << s | al >> (64 - s) : ah;
+  uint64_t rem, high, p0, p1, p2, carry, borrow;
+  q = div128(a2, a1, top, rem);
+
+  mul64(q, bl, high, p0);
+  mul64(q, bh, p2, p1);
+  p1 = add64(p1, high, 0, carry);
+  p2 += carry;
+  while (p2 || p1 > ah || (p1 == ah && p0 > al)) {
+    q--;
+    p0 = sub64(p0, bl, 0, borrow);
+    p1 = sub64(p1, bh, borrow, borrow);
+    p2 -= borrow;
+  }
+  al = sub64(al, p0, 0, borrow);
+  ah -= p1 + borrow;
+  return true;
+}
+
+// euclid steps taken by lehmer: (a, b) = (m00 a' + m01 b', m10 a' + m11 b')
+// for the reduced pair (a', b'), entries below 2^63, determinant -1 if odd
+// and 1 otherwise.
+struct Step {
+  uint64_t m00, m01, m10, m11;
+  bool odd;
+};
+
+// euclid on the leading 128 bits of a >= b > 0 (b may be shorter). the
+// quotients are kept while they provably are those of the full values:
+// with the approximations reduced to (alpha, beta), while
+// beta >= max(m00, m10) and alpha - beta >= max(m00 + m01, m10 + m11).
+// no step takes b below 2^min_bits. false if not a single step was kept.
+static bool lehmer(const uint64_t *a, const size_t na, const uint64_t *b,
+                   const size_t nb, const uint64_t min_bits, Step &st) {
+  const uint64_t bits = 64 * na - clz64(a[na - 1]);
+  const uint64_t p = bits > 128 ? bits - 128 : 0;
+  uint64_t ah = bits_at(a, na, p + 64), al = bits_at(a, na, p);
+  uint64_t bh = bits_at(b, nb, p + 64), bl = bits_at(b, nb, p);
+
+  // 2^(min_bits - p), the floor for beta
+  uint64_t fh = 0, fl = 0;
+  if (min_bits >= p + 128) return false;
+  if (min_bits >= p + 64) fh = (uint64_t)1 << (min_bits - p - 64);
+  else if (min_bits > p) fl = (uint64_t)1 << (min_bits - p);
+
+  st = {1, 0, 0, 1, false};
+  bool kept = false;
+  const uint64_t limit = (uint64_t)1 << 63;
+  while (bh || bl) {
+    uint64_t rh = ah, rl = al, q, h0, h1, c0, c1;
+    if (!divstep128(rh, rl, bh, bl, q)) break;
+    if (rh < fh || (rh == fh && rl < fl)) break;
+
+    mul64(q, st.m00, h0, c0);
+    const uint64_t n00 = add64(c0, st.m01, 0, c0);
+    mul64(q, st.m10, h1, c1);
+    const uint64_t n10 = add64(c1, st.m11, 0, c1);
+    if (h0 | c0 | h1 | c1 || n00 >= limit || n10 >= limit) break;
+
+    if (p) { // exact below 128 bits
+      uint64_t borrow;
+      const uint64_t dl = sub64(bl, rl, 0, borrow), dh = bh - rh - borrow;
+      const uint64_t col = std::max(n00, n10);
+      const uint64_t row = std::max(n00 + st.m00, n10 + st.m10);
+      if ((rh == 0 && rl < col) || (dh == 0 && dl < row)) break;
+    }
+
+    st.m01 = st.m00;
+    st.m00 = n00;
+    st.m11 = st.m10;
+    st.m10 = n10;
+    st.odd = !st.odd;
+    ah = bh;
+    al = bl;
+    bh = rh;
+    bl = rl;
+    kept = true;
+  }
+  return kept;
+}
+
+// (a, b) = st^-1 (a, b) over n limbs, into t and u, which swap places with a
+// and b. the results are known to be in [0, a).
+static void lehmer_apply(uint64_t *&a, uint64_t *&b, uint64_t *&t, uint64_t *&u,
+                         const size_t n, const Step &st) {
+  if (!st.odd) {
+    mul_1(t, a, n, st.m11);
+    submul_1(t, b, n, st.m01);
+    mul_1(u, b, n, st.m00);
+    submul_1(u, a, n, st.m10);
+  } else {
+    mul_1(t, b, n, st.m01);
+    submul_1(t, a, n, st.m11);
+    mul_1(u, a, n, st.m10);
+    submul_1(u, b, n, st.m00);
+  }
+  std::swap(a, t);
+  std::swap(b, u);
+}
+
+// (x, y) = st^-1 (x, y) for any signs
+static void step_apply(const Step &st, Integer &x, Integer &y) {
+  Integer t0, t1, t2;
+  Integer::mul_64bits(x, (int64_t)st.m11, t0);
+  Integer::mul_64bits(y, (int64_t)st.m01, t2);
+  t0 -= t2;
+  Integer::mul_64bits(y, (int64_t)st.m00, t1);
+  Integer::mul_64bits(x, (int64_t)st.m10, t2);
+  t1 -= t2;
+  if (st.odd) {
+    Integer::opp(t0, t0);
+    Integer::opp(t1, t1);
+  }
+  x = std::move(t0);
+  y = std::move(t1);
+}
+
+// x = a mod b step on the cofactors: (u0, u1) = (u1, u0 - q * u1)
+static void quot_apply(const Integer &q, Integer &u0, Integer &u1) {
+  u0 -= q * u1;
+  std::swap(u0, u1);
+}
+
+// gcd of a >= b > 0 by lehmer steps, or plain euclid steps where lehmer
+// cannot go, from tuning.gcd_lehmer limbs and binary gcd below. u, when
+// given, holds the cofactors of a and b in terms of the inputs of the
+// whole computation and is kept up to date (lehmer all the way down then).
+static Integer gcd_small(const Integer &x, const Integer &y, Integer *u) {
+  const VecU64 &vx = x.view_v(), &vy = y.view_v();
+  size_t n = vx.size(), ny = vy.size();
+  Scratch tmp(5 * n + 1 + divrem_itch(n, n));
+  uint64_t *a = tmp.data(), *b = a + n, *t = b + n, *w = t + n;
+  uint64_t *q = w + n, *s = q + n + 1;
+  std::copy(vx.begin(), vx.end(), a);
+  std::copy(vy.begin(), vy.end(), b);
+  std::fill(b + ny, b + n, 0);
+
+  Step st;
+  while ((ny = norm_size(b, n))) {
+    if (!u && n < tuning.gcd_lehmer && ny + 1 >= n) {
+      const uint64_t k = std::min(strip_zeros(a, n), strip_zeros(b, n));
+      size_t size;
+      const uint64_t *g = binary_gcd(a, b, n, size);
+      std::fill(t, t + n, 0);
+      if (k % 64) {
+        const uint64_t top = lshift(t + k / 64, g, size, k % 64);
+        if (k / 64 + size < n) t[k / 64 + size] = top;
+      } else {
+        std::copy(g, g + size, t + k / 64);
+      }
+      return Integer::from_limbs(t, n);
+    }
+
+    if (lehmer(a, n, b, ny, 0, st)) {
+      lehmer_apply(a, b, t, w, n, st);
+      if (u) step_apply(st, u[0], u[1]);
+    } else {
+      divrem_(q, t, a, n, b, ny, s);
+      std::fill(t + ny, t + n, 0);
+      if (u) quot_apply(Integer::from_limbs(q, n - ny + 1), u[0], u[1]);
+      std::swap(a, t); // a = r
+      std::swap(a, b);
+    }
+    n = norm_size(a, n);
+  }
+  return Integer::from_limbs(a, n);
+}
+
+// a product of euclid steps with Integer entries, as Step. entries of
+// lifted steps may be negative.
+struct Matrix {
+  Integer m00 = 1, m01 = 0, m10 = 0, m11 = 1;
+  bool odd = false;
+
+  bool identity() const { return m01.zero() && m10.zero(); }
+};
+
+// (x, y) = m^-1 (x, y)
+static void mat_apply(const Matrix &m, Integer &x, Integer &y) {
+  Integer t0 = m.m11 * x, t1 = m.m00 * y;
+  t0 -= m.m01 * y;
+  t1 -= m.m10 * x;
+  if (m.odd) {
+    Integer::opp(t0, t0);
+    Integer::opp(t1, t1);
+  }
+  x = std::move(t0);
+  y = std::move(t1);
+}
+
+// m = m * r
+static void mat_mul(Matrix &m, const Matrix &r) {
+  Integer n00 = m.m00 * r.m00 + m.m01 * r.m10;
+  Integer n01 = m.m00 * r.m01 + m.m01 * r.m11;
+  Integer n10 = m.m10 * r.m00 + m.m11 * r.m10;
+  m.m11 = m.m10 * r.m01 + m.m11 * r.m11;
+  m.m00 = std::move(n00);
+  m.m01 = std::move(n01);
+  m.m10 = std::move(n10);
+  m.odd = m.odd != r.odd;
+}
+
+// m = m * st
+static void mat_mul(Matrix &m, const Step &st) {
+  Matrix r;
+  r.m00 = (int64_t)st.m00;
+  r.m01 = (int64_t)st.m01;
+  r.m10 = (int64_t)st.m10;
+  r.m11 = (int64_t)st.m11;
+  r.odd = st.odd;
+  mat_mul(m, r);
+}
+
+// m = m * (q 1; 1 0)
+static void mat_mul(Matrix &m, const Integer &q) {
+  Integer n00 = m.m00 * q + m.m01, n10 = m.m10 * q + m.m11;
+  m.m01 = std::move(m.m00);
+  m.m11 = std::move(m.m10);
+  m.m00 = std::move(n00);
+  m.m10 = std::move(n10);
+  m.odd = !m.odd;
+}
+
+// x >= y >= 0 again after a lifted step: signs and order, mirrored on the
+// columns of m
+static void mat_fix(Integer &x, Integer &y, Matrix &m) {
+  if (x.neg()) {
+    Integer::opp(x, x);
+    Integer::opp(m.m00, m.m00);
+    Integer::opp(m.m10, m.m10);
+    m.odd = !m.odd;
+  }
+  if (y.neg()) {
+    Integer::opp(y, y);
+    Integer::opp(m.m01, m.m01);
+    Integer::opp(m.m11, m.m11);
+    m.odd = !m.odd;
+  }
+  if (x < y) {
+    std::swap(x, y);
+    std::swap(m.m00, m.m01);
+    std::swap(m.m10, m.m11);
+    m.odd = !m.odd;
+  }
+}
+
+// t[0, ne + 1) = e0 * s0 + e1 * s1, entries of ne limbs
+static void entry_step(uint64_t *t, const uint64_t *e0, const uint64_t *e1,
+                       const size_t ne, const uint64_t s0, const uint64_t s1) {
+  t[ne] = mul_1(t, e0, ne, s0);
+  t[ne] += addmul_1(t, e1, ne, s1);
+}
+
+// (e0, e1) = (e0 * q + e1, e0), entries of ne limbs; f is free before and
+// after
+static void entry_quot(uint64_t *&e0, uint64_t *&e1, uint64_t *&f,
+                       const size_t ne, const uint64_t *q, const size_t nq) {
+  if (ne >= nq) umul_(f, e0, ne, q, nq);
+  else umul_(f, q, nq, e0, ne);
+  add_1(f + ne, nq, add_n(f, f, e1, ne));
+  uint64_t *old = e1;
+  e1 = e0;
+  e0 = f;
+  f = old;
+}
+
+// hgcd below tuning.hgcd_dc limbs on raw limbs: lehmer steps, and euclid
+// steps where lehmer cannot go, while b stays above 2^s. the entries of m
+// are at most x / 2^s and non-negative here.
+static void hgcd_base(Integer &x, Integer &y, const uint64_t s, Matrix &m) {
+  const VecU64 &vx = x.view_v(), &vy = y.view_v();
+  size_t n = vx.size(), ny = vy.size(), ne = 1;
+  const size_t c = n + 2; // limbs per entry
+  Scratch tmp(5 * n + 1 + divrem_itch(n, n) + 6 * c);
+  uint64_t *a = tmp.data(), *b = a + n, *t = b + n, *w = t + n;
+  uint64_t *q = w + n, *sc = q + n + 1, *e = sc + divrem_itch(n, n);
+  std::copy(vx.begin(), vx.end(), a);
+  std::copy(vy.begin(), vy.end(), b);
+  std::fill(b + ny, b + n, 0);
+  std::fill(e, e + 6 * c, 0);
+
+  // rows (e00, e01) and (e10, e11), f0 and f1 free
+  uint64_t *e00 = e, *e01 = e00 + c, *e10 = e01 + c, *e11 = e10 + c;
+  uint64_t *f0 = e11 + c, *f1 = f0 + c;
+  e00[0] = e11[0] = 1;
+  bool odd = false;
+
+  Step st;
+  while (true) {
+    ny = norm_size(b, n);
+    if (64 * ny - clz64(b[ny - 1]) <= s) break;
+
+    if (lehmer(a, n, b, ny, s, st)) {
+      lehmer_apply(a, b, t, w, n, st);
+      entry_step(f0, e00, e01, ne, st.m00, st.m10);
+      entry_step(f1, e00, e01, ne, st.m01, st.m11);
+      std::swap(e00, f0);
+      std::swap(e01, f1);
+      entry_step(f0, e10, e11, ne, st.m00, st.m10);
+      entry_step(f1, e10, e11, ne, st.m01, st.m11);
+      std::swap(e10, f0);
+      std::swap(e11, f1);
+      ne++;
+      odd = odd != st.odd;
+    } else {
+      divrem_(q, t, a, n, b, ny, sc);
+      const size_t nr = norm_size(t, ny);
+      if (nr == 0 || 64 * nr - clz64(t[nr - 1]) <= s) break;
+      std::fill(t + ny, t + n, 0);
+      std::swap(a, t);
+      std::swap(a, b);
+
+      const size_t nq = norm_size(q, n - ny + 1);
+      entry_quot(e00, e01, f0, ne, q, nq);
+      entry_quot(e10, e11, f0, ne, q, nq);
+      ne += nq;
+      odd = !odd;
+    }
+    n = norm_size(a, n);
+    while (ne > 1 && !(e00[ne - 1] | e01[ne - 1] | e10[ne - 1] | e11[ne - 1])) {
+      ne--;
+    }
+  }
+
+  x = Integer::from_limbs(a, n);
+  y = Integer::from_limbs(b, n);
+  m.m00 = Integer::from_limbs(e00, ne);
+  m.m01 = Integer::from_limbs(e01, ne);
+  m.m10 = Integer::from_limbs(e10, ne);
+  m.m11 = Integer::from_limbs(e11, ne);
+  m.odd = odd;
+}
+
+static void hgcd(Integer &a, Integer &b, Matrix &m);
+
+// reduces the part of a >= b above bit p by hgcd and lifts the steps to
+// the whole values. they are not exact there, so the results are only
+// about the size hgcd promises, and fixed up into a >= b >= 0 again.
+static void hgcd_lift(Integer &a, Integer &b, const uint64_t p, Matrix &m) {
+  Integer x = a >> p, y = b >> p;
+  Matrix r;
+  hgcd(x, y, r);
+  if (r.identity()) return;
+
+  mat_apply(r, a, b);
+  mat_fix(a, b, r);
+  mat_mul(m, r);
+}
+
+// half gcd: reduces a >= b >= 0 of n bits until b is about n / 2 bits,
+// with (a, b) before = m (a, b) after and a >= b >= 0. from tuning.hgcd_dc
+// limbs the top half goes first (recursively, lifted to the whole values),
+// then the top half of what is left; lehmer and euclid steps do the rest.
+static void hgcd(Integer &a, Integer &b, Matrix &m) {
+  m = Matrix();
+  const uint64_t n = bit_size(a), s = n / 2 + 1;
+  if (bit_size(b) <= s) return;
+
+  if (a.view_v().size() < tuning.hgcd_dc) {
+    hgcd_base(a, b, s, m);
+    return;
+  }
+
+  hgcd_lift(a, b, n / 2, m);
+  // the second part must be shorter than a was, or this recursion would
+  // not shrink when the first made no progress (a = b, say)
+  const uint64_t n2 = bit_size(a);
+  if (bit_size(b) > s && n2 > s + 64 && n2 < n) {
+    hgcd_lift(a, b, 2 * s - n2, m);
+  }
+
+  Step st;
+  Integer q, r;
+  while (bit_size(b) > s) {
+    const VecU64 &va = a.view_v(), &vb = b.view_v();
+    if (lehmer(va.data(), va.size(), vb.data(), vb.size(), s, st)) {
+      step_apply(st, a, b);
+      mat_mul(m, st);
+      continue;
+    }
+    Integer::div(a, b, q, &r);
+    if (bit_size(r) <= s) break;
+    a = std::move(b);
+    b = std::move(r);
+    mat_mul(m, q);
+  }
+}
+
+// brings a >= b > 0 below tuning.gcd_dc limbs by half gcd rounds on the top
+// two thirds of a, each taking off about a third of its bits. u as for
+// gcd_small.
+static void gcd_dc(Integer &a, Integer &b, Integer *u) {
+  Matrix m;
+  Integer q, r;
+  while (b.view_v().size() >= tuning.gcd_dc) {
+    const uint64_t n = bit_size(a);
+    Integer x = a >> n / 3, y = b >> n / 3;
+    hgcd(x, y, m);
+    if (!m.identity()) {
+      Integer ca = a, cb = b;
+      mat_apply(m, ca, cb);
+      mat_fix(ca, cb, m);
+      if (bit_size(ca) < n) { // no progress is possible in principle
+        a = std::move(ca);
+        b = std::move(cb);
+        if (u) mat_apply(m, u[0], u[1]);
+        continue;
+      }
+    }
+
+    Integer::div(a, b, q, &r);
+    a = std::move(b);
+    b = std::move(r);
+    if (u) quot_apply(q, u[0], u[1]);
+  }
+}
+
+Integer gcd(const Integer &a, const Integer &b) {
+  Integer x = a.abs(), y = b.abs();
+  if (x < y) std::swap(x, y);
+  if (y.zero()) return x;
+  if (x.view_v().size() == 1) {
+    const uint64_t g = gcd64(x.abs_low64(), y.abs_low64());
+    return Integer::from_limbs(&g, 1);
+  }
+
+  gcd_dc(x, y, nullptr);
+  return y.zero() ? x : gcd_small(x, y, nullptr);
+}
+
+Integer gcdext(const Integer &a, const Integer &b, Integer &s, Integer *t) {
+  const bool swapped = a.abs() < b.abs();
+  const Integer x0 = swapped ? b.abs() : a.abs();
+  const Integer y0 = swapped ? a.abs() : b.abs();
+
+  // g = sx * x0 + sy * y0
+  Integer g, sx, sy;
+  if (y0.zero()) {
+    g = x0;
+    sx = x0.zero() ? 0 : 1;
+  } else {
+    Integer x = x0, y = y0, u[2] = {1, 0};
+    gcd_dc(x, y, u);
+    g = y.zero() ? std::move(x) : gcd_small(x, y, u);
+
+    // the cofactor of least magnitude
+    const Integer m = y0 / g;
+    sx = u[0] % m;
+    if (sx.neg()) sx += m;
+    if (sx * 2 > m) sx -= m;
+    sy = (g - sx * x0) / y0;
+  }
+
+  if (swapped) std::swap(sx, sy);
+  s = a.neg() ? -sx : sx;
+  if (t) *t = b.neg() ? -sy : sy;
+  return g;
+}
+
+Integer invert(const Integer &a, const Integer &m) {
+  if (m <= 1) throw std::domain_error("m <= 1.");
+
+  Integer s;
+  if (gcdext(a, m, s) != 1) throw std::domain_error("a is not invertible.");
+  if (s.neg()) s += m;
+  return s;
+}
+} // namespace lll
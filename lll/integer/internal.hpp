@@ -2,76 +2,236 @@
 #define LLL_INTEGER_INTERNAL_HPP
 
 #include "../integer.hpp"
+#include "word.hpp"
+#include <cstring>
 
 namespace lll {
 using VecU64 = Integer::VecView;
 
 namespace internal {
-// a + b + c, carry = 0, 1, 2
-static inline uint64_t add64(const uint64_t a, const uint64_t b,
-                             const uint64_t c, uint64_t &carry) {
-  uint64_t res = a + b;
-  const uint64_t carry1 = res < b;
+static inline uint64_t abs64(const int64_t x) {
+  return x < 0 ? -x : x;
+}
 
-  res += c;
-  const uint64_t carry2 = res < c;
+// bits of |x|, 0 for x = 0
+static inline uint64_t bit_size(const Integer &x) {
+  return x.zero() ? 0 : x.abs_log2() + 1;
+}
+
+static inline void assign64(VecU64 &a, const uint64_t value) {
+  a.assign(value != 0, value);
+}
+
+static inline void norm_top(VecU64 &a) {
+  if (!a.empty() && a.back() == 0) a.pop_back();
+}
 
-  carry = carry1 + carry2;
-  return res;
+static inline void norm(VecU64 &a) {
+  size_t i = a.size();
+  while (i-- && a[i] == 0);
+  a.resize(i + 1);
 }
 
-// a - b - c, borrow = 0, 1, 2
-static inline uint64_t sub64(const uint64_t a, const uint64_t b,
-                             const uint64_t c, uint64_t &borrow) {
-  const uint64_t borrow1 = a < b;
-  uint64_t res = a - b;
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define LLL_X86_64_ASM
+#endif
+
+#ifdef LLL_X86_64_ASM
+// inline assembly behind add_n, sub_n, mul_1 and addmul_1 from KERNEL_MIN
+// limbs (kernels.cpp): adc and sbb chains, which every x86-64 has, and rows
+// on mulx (bmi2) and adcx/adox (adx), which are null without them.
+constexpr size_t KERNEL_MIN = 8;
+uint64_t add_n_x86(uint64_t *r, const uint64_t *a, const uint64_t *b,
+                   size_t n);
+uint64_t sub_n_x86(uint64_t *r, const uint64_t *a, const uint64_t *b,
+                   size_t n);
+struct LimbKernels {
+  uint64_t (*mul_1)(uint64_t *r, const uint64_t *a, size_t n, uint64_t b);
+  uint64_t (*addmul_1)(uint64_t *r, const uint64_t *a, size_t n, uint64_t b);
+};
+extern const LimbKernels limb_kernels;
+#endif
 
-  const uint64_t borrow2 = res < c;
-  res -= c;
+// raw limb helpers, little-endian, lengths in limbs.
+
+// r = a + b, returns carry. r may alias a or b.
+static inline uint64_t add_n(uint64_t *r, const uint64_t *a, const uint64_t *b,
+                             const size_t n) {
+#ifdef LLL_X86_64_ASM
+  if (n >= KERNEL_MIN) return add_n_x86(r, a, b, n);
+#endif
+  uint64_t carry = 0;
+  for (size_t i = 0; i < n; i++) r[i] = add64(a[i], b[i], carry, carry);
+  return carry;
+}
+
+// r = a - b, returns borrow. r may alias a or b.
+static inline uint64_t sub_n(uint64_t *r, const uint64_t *a, const uint64_t *b,
+                             const size_t n) {
+#ifdef LLL_X86_64_ASM
+  if (n >= KERNEL_MIN) return sub_n_x86(r, a, b, n);
+#endif
+  uint64_t borrow = 0;
+  for (size_t i = 0; i < n; i++) r[i] = sub64(a[i], b[i], borrow, borrow);
+  return borrow;
+}
 
-  borrow = borrow1 + borrow2;
-  return res;
+// r += c, returns carry out of the n limbs.
+static inline uint64_t add_1(uint64_t *r, const size_t n, uint64_t c) {
+  for (size_t i = 0; c && i < n; i++) c = (r[i] += c) < c;
+  return c;
 }
 
-static inline void mul64(const uint64_t a, const uint64_t b, uint64_t &high,
-                         uint64_t &low) {
-#if defined(_MSC_VER)
-  low = _umul128(a, b, &high);
-#elif defined(__GNUC__) || defined(__clang__)
-  const __uint128_t prod = (__uint128_t)a * (__uint128_t)b;
-  low = (uint64_t)prod;
-  high = (uint64_t)(prod >> 64);
-#else
+// r -= c, returns borrow out of the n limbs.
+static inline uint64_t sub_1(uint64_t *r, const size_t n, uint64_t c) {
+  for (size_t i = 0; c && i < n; i++) {
+    const uint64_t t = r[i];
+    r[i] = t - c;
+    c = t < c;
+  }
+  return c;
+}
 
+// r = a * b, returns the high limb. r may alias a.
+static inline uint64_t mul_1(uint64_t *r, const uint64_t *a, const size_t n,
+                             const uint64_t b) {
+#ifdef LLL_X86_64_ASM
+  if (n >= KERNEL_MIN && limb_kernels.mul_1)
+    return limb_kernels.mul_1(r, a, n, b);
 #endif
+  uint64_t high, low, carry = 0;
+  for (size_t i = 0; i < n; i++) {
+    mul64(a[i], b, high, low);
+    r[i] = add64(low, carry, 0, carry);
+    carry += high;
+  }
+  return carry;
 }
 
-static inline uint64_t clz64(const uint64_t n) {
-#ifdef _MSC_VER
-  unsigned long res;
-  _BitScanReverse64(&res, n);
-  return 63 - res;
-#elif defined(__GNUC__) || defined(__clang__)
-  return __builtin_clzll(n);
+// r += a * b, returns the high limb.
+static inline uint64_t addmul_1(uint64_t *r, const uint64_t *a, const size_t n,
+                                const uint64_t b) {
+#ifdef LLL_X86_64_ASM
+  if (n >= KERNEL_MIN && limb_kernels.addmul_1)
+    return limb_kernels.addmul_1(r, a, n, b);
 #endif
+  uint64_t high, low, carry = 0;
+  for (size_t i = 0; i < n; i++) {
+    mul64(a[i], b, high, low);
+    r[i] = add64(r[i], low, carry, carry);
+    carry += high;
+  }
+  return carry;
 }
 
-static inline uint64_t abs64(const int64_t x) {
-  return x < 0 ? -x : x;
+// r -= a * b, returns the borrow limb.
+static inline uint64_t submul_1(uint64_t *r, const uint64_t *a, const size_t n,
+                                const uint64_t b) {
+  uint64_t high, low, borrow = 0;
+  for (size_t i = 0; i < n; i++) {
+    mul64(a[i], b, high, low);
+    r[i] = sub64(r[i], low, borrow, borrow);
+    borrow += high;
+  }
+  return borrow;
 }
 
-static inline void assign64(VecU64 &a, const uint64_t value) {
-  a.assign(value != 0, value);
+// r = a << s, 0 < s < 64, returns the bits shifted out. r may alias a.
+static inline uint64_t lshift(uint64_t *r, const uint64_t *a, const size_t n,
+                              const uint64_t s) {
+  const uint64_t out = a[n - 1] >> (64 - s);
+  for (size_t i = n - 1; i; i--) r[i] = a[i] << s | a[i - 1] >> (64 - s);
+  r[0] = a[0] << s;
+  return out;
 }
 
-static inline void norm_top(VecU64 &a) {
-  if (a.back() == 0) a.pop_back();
+// r = a >> s, 0 < s < 64, returns the bits shifted out (at the top of the
+// limb). r may alias a.
+static inline uint64_t rshift(uint64_t *r, const uint64_t *a, const size_t n,
+                              const uint64_t s) {
+  const uint64_t out = a[0] << (64 - s);
+  for (size_t i = 0; i + 1 < n; i++) r[i] = a[i] >> s | a[i + 1] << (64 - s);
+  r[n - 1] = a[n - 1] >> s;
+  return out;
 }
 
-static void norm(VecU64 &a) {
-  size_t i = a.size();
-  while (i-- && a[i] == 0);
-  a.resize(i + 1);
+// sign of a - b
+static inline int cmp_n(const uint64_t *a, const uint64_t *b, size_t n) {
+  while (n--) {
+    if (a[n] != b[n]) return a[n] > b[n] ? 1 : -1;
+  }
+  return 0;
+}
+
+static inline size_t norm_size(const uint64_t *a, size_t n) {
+  while (n && a[n - 1] == 0) n--;
+  return n;
+}
+
+// n limbs of per-thread temporary space, uninitialized. released buffers
+// are kept for the next Scratch on the same thread, so loops of similar
+// operations stop allocating after their first pass.
+class Scratch {
+public:
+  explicit Scratch(size_t n);
+  ~Scratch();
+  Scratch(const Scratch &) = delete;
+  Scratch &operator=(const Scratch &) = delete;
+
+  uint64_t *data() { return buf_.data(); }
+
+private:
+  VecU64 buf_;
+};
+
+// scratch limbs umul_ and usqr_ need for operands up to n limbs.
+size_t mul_itch(size_t n);
+// r[0, na + nb) = a * b, na >= nb > 0. r must not overlap a or b. tmp is
+// mul_itch(na) limbs, or null to take a Scratch.
+void umul_(uint64_t *r, const uint64_t *a, size_t na, const uint64_t *b,
+           size_t nb, uint64_t *tmp = nullptr);
+// r[0, 2n) = a * a, n > 0. r must not overlap a. tmp as for umul_.
+void usqr_(uint64_t *r, const uint64_t *a, size_t n, uint64_t *tmp = nullptr);
+// same contract as umul_ (a == b squares), through three-prime number
+// theoretic transforms.
+void umul_ntt_(uint64_t *r, const uint64_t *a, size_t na, const uint64_t *b,
+               size_t nb);
+
+// sliding window width for an exponent of the given bit length.
+static inline uint64_t window_bits(const uint64_t bits) {
+  static const uint64_t limits[] = {7, 25, 81, 241, 673, 1793};
+  uint64_t k = 1;
+  for (const uint64_t l : limits) k += bits > l;
+  return k;
+}
+
+// left to right sliding window scan over the exponent bits [0, top], bit
+// top set, with windows of at most k bits. set(j) starts the result at
+// b ^ (2j + 1); sqr() and mul(j), multiplying by b ^ (2j + 1), advance it.
+template <typename Set, typename Sqr, typename Mul>
+void sliding_window(const uint64_t *e, const uint64_t top, const uint64_t k,
+                    Set set, Sqr sqr, Mul mul) {
+  const auto bit = [e](const uint64_t i) { return e[i / 64] >> (i % 64) & 1; };
+  bool first = true;
+  for (uint64_t i = top + 1; i--;) {
+    if (!bit(i)) {
+      sqr();
+      continue;
+    }
+    uint64_t j = i + 1 > k ? i + 1 - k : 0;
+    while (!bit(j)) j++;
+
+    uint64_t val = 0;
+    for (uint64_t l = i + 1; l-- > j;) val = val << 1 | bit(l);
+    if (first) {
+      set(val >> 1);
+      first = false;
+    } else {
+      for (uint64_t l = j; l <= i; l++) sqr();
+      mul(val >> 1);
+    }
+    i = j;
+  }
 }
 
 int ucmp(const VecU64 &a, const VecU64 &b);
@@ -79,6 +239,23 @@ void uadd_64bits_(const VecU64 &a, uint64_t b, VecU64 &out);
 void usub_64bits_(const VecU64 &a, uint64_t b, VecU64 &out);
 void umul_64bits_(const VecU64 &a, uint64_t b, VecU64 &out);
 void udiv_64bits_(const VecU64 &ddd, uint64_t dsr, VecU64 &quot, uint64_t &rem);
+// q[0, n) = a / d, returns a % d. q may alias a; q may be null.
+uint64_t divrem_1_(uint64_t *q, const uint64_t *a, size_t n, uint64_t d);
+// divrem_1_ with d << shift and its reciprocal64 v precomputed.
+uint64_t divrem_1_preinv_(uint64_t *q, const uint64_t *a, size_t n, uint64_t d,
+                          uint64_t shift, uint64_t v);
+// scratch limbs divrem_ needs: the shifted copies of a and d, then for
+// burnikel-ziegler a quotient and a correction product with umul_'s scratch.
+static inline size_t divrem_itch(const size_t na, const size_t nd) {
+  return na + nd + 1 + (nd > 1 ? na + 1 + mul_itch(nd) : 0);
+}
+// q[0, na - nd + 1) = a / d, r[0, nd) = a % d, na >= nd > 0, d[nd - 1] != 0.
+// q or r may be null. both may alias a or d but not each other or tmp,
+// which is divrem_itch(na, nd) limbs.
+void divrem_(uint64_t *q, uint64_t *r, const uint64_t *a, size_t na,
+             const uint64_t *d, size_t nd, uint64_t *tmp);
+// quot = a / b, rem = a % b, b != 0; quot may alias a or b.
+void udiv_(const VecU64 &a, const VecU64 &b, VecU64 &quot, VecU64 *rem);
 } // namespace internal
 } // namespace lll
 
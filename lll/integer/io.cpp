@@ -1,8 +1,13 @@
+#include "divisor.hpp"
 #include "internal.hpp"
+#include "parallel.hpp"
+#include "tuning.hpp"
 #include <cmath>
 #include <cstring>
+#include <deque>
 #include <iostream>
 #include <algorithm>
+#include <mutex>
 
 namespace lll {
 using namespace internal;
@@ -12,9 +17,9 @@ constexpr uint64_t MAX_DIGITS = 19;
 constexpr uint64_t BASE = 10000000000000000000llu; // 10^19
 
 static uint64_t *base_cache() {
-  static uint64_t cache[19];
+  static uint64_t cache[MAX_DIGITS + 1];
   cache[0] = 1;
-  for (size_t i = 1; i < MAX_DIGITS; i++) cache[i] = cache[i - 1] * 10;
+  for (size_t i = 1; i <= MAX_DIGITS; i++) cache[i] = cache[i - 1] * 10;
   return cache;
 }
 
@@ -24,8 +29,56 @@ static uint64_t from_string_base(const char *src, const size_t len) {
   return n;
 }
 
+// 10^(19 * 2^k), built by repeated squaring on first use. a deque keeps
+// references valid while other threads extend it.
+static const VecU64 &base_pow(const size_t k) {
+  static std::mutex mutex;
+  static std::deque<VecU64> cache;
+
+  std::lock_guard<std::mutex> guard(mutex);
+  if (cache.empty()) cache.emplace_back(1, BASE);
+  while (cache.size() <= k) {
+    const VecU64 &last = cache.back();
+    VecU64 next(2 * last.size());
+    usqr_(next.data(), last.data(), last.size());
+    norm_top(next);
+    cache.push_back(std::move(next));
+  }
+  return cache[k];
+}
+
+// out = high * p + low
+static void mul_add(const VecU64 &high, const VecU64 &p, const VecU64 &low,
+                    VecU64 &out) {
+  if (high.empty()) {
+    out = low;
+    return;
+  }
+  const VecU64 &max = high.size() >= p.size() ? high : p;
+  const VecU64 &min = &max == &high ? p : high;
+  out.assign(max.size() + min.size() + 1, 0);
+  umul_(out.data(), max.data(), max.size(), min.data(), min.size());
+  add_1(out.data() + low.size(), out.size() - low.size(),
+        add_n(out.data(), out.data(), low.data(), low.size()));
+  norm(out);
+}
+
 static void from_string_u(VecU64 &abs, const char *ptr, size_t size) {
   static const uint64_t *base_10_ = base_cache();
+  if (size > MAX_DIGITS * tuning.str_dc) {
+    // split off the low 19 * 2^k digits, as many as fit below the top part
+    size_t k = 0;
+    while (MAX_DIGITS << (k + 1) < size) k++;
+    const size_t low_size = MAX_DIGITS << k;
+
+    VecU64 high, low;
+    from_string_u(high, ptr, size - low_size);
+    from_string_u(low, ptr + size - low_size, low_size);
+    mul_add(high, base_pow(k), low, abs);
+    return;
+  }
+
+  abs.clear();
   while (size > MAX_DIGITS) {
     umul_64bits_(abs, BASE, abs);
     uadd_64bits_(abs, from_string_base(ptr, MAX_DIGITS), abs);
@@ -63,18 +116,66 @@ static size_t to_string_u_rev(const VecU64 &abs, char *dst) {
   const size_t size = abs.size();
   if (size == 1) return to_string_base(abs[0], dst, false);
 
-  VecU64 quot = abs;
-  uint64_t rem = 0, len = 0;
-  for (char *p = dst;;) {
-    udiv_64bits_(quot, BASE, quot, rem);
-    const bool quot_zero = quot.empty();
-    len += to_string_base(rem, p, !quot_zero);
-    p += MAX_DIGITS;
-    if (quot_zero) break;
+  static const Divisor64 base(BASE);
+  Scratch tmp(size);
+  uint64_t *quot = tmp.data();
+  std::copy(abs.begin(), abs.end(), quot);
+  uint64_t len = 0;
+  for (size_t n = size;;) {
+    const uint64_t rem = base.divrem(quot, quot, n);
+    n = norm_size(quot, n);
+    len += to_string_base(rem, dst + len, n != 0);
+    if (n == 0) break;
   }
   return len;
 }
 
+// |x| in decimal, left zero padded to width digits (x < 10^width) unless
+// width is 0. returns the number of digits written. from tuning.str_parallel
+// limbs up to tuning.mul_parallel the two halves convert on up to threads
+// threads; above that the divisions use them, below it is all one thread.
+static size_t to_string_u(const VecU64 &x, char *dst, const size_t width,
+                          const size_t threads) {
+  if (x.size() < std::max<size_t>(tuning.str_dc, 2)) {
+    size_t len = x.empty() ? 0 : to_string_u_rev(x, dst);
+    if (len < width) {
+      memset(dst + len, '0', width - len);
+      len = width;
+    }
+    std::reverse(dst, dst + len);
+    return len;
+  }
+
+  // the largest 10^(19 * 2^k) of at most half the limbs of x
+  size_t k = 0;
+  while (2 * base_pow(k + 1).size() <= x.size()) k++;
+  const size_t low_width = MAX_DIGITS << k;
+
+  VecU64 quot, rem;
+  udiv_(x, base_pow(k), quot, &rem);
+  if (threads < 2 || x.size() < tuning.str_parallel ||
+      x.size() >= tuning.mul_parallel) {
+    const size_t len =
+        to_string_u(quot, dst, width ? width - low_width : 0, threads);
+    to_string_u(rem, dst + len, low_width, threads);
+    return len + low_width;
+  }
+
+  // the digits of quot fill dst up to where those of rem start, unless
+  // width is 0: then rem goes after them once their count is known
+  const size_t quot_width = width ? width - low_width : 0;
+  const size_t half = threads / 2;
+  std::string tail(width ? 0 : low_width, '\0');
+  char *const low = width ? dst + quot_width : &tail[0];
+  size_t len = 0;
+  parallel_for(2, 2, [&](const size_t i) {
+    if (i == 0) len = to_string_u(quot, dst, quot_width, threads - half);
+    else to_string_u(rem, low, low_width, half);
+  });
+  if (!width) memcpy(dst + len, low, low_width);
+  return len + low_width;
+}
+
 std::string Integer::to_string() const {
   if (zero()) return "0";
 
@@ -88,9 +189,9 @@ std::string Integer::to_string() const {
     ptr++;
   }
 
-  const size_t len = to_string_u_rev(abs_val_, ptr);
+  const size_t len =
+      to_string_u(abs_val_, ptr, 0, thread_count(tuning.threads));
   str.resize(len + neg_);
-  std::reverse(ptr, ptr + len);
   return str;
 }
 
@@ -0,0 +1,204 @@
+#include "internal.hpp"
+
+#ifdef LLL_X86_64_ASM
+#include <cpuid.h>
+#endif
+
+namespace lll {
+using namespace internal;
+
+#ifdef LLL_X86_64_ASM
+// the loops below go four limbs a turn; the n % 4 limbs below them take the
+// portable path first and hand over their carry. addq $-1 turns a carry of
+// 0 or 1 into CF.
+
+uint64_t internal::add_n_x86(uint64_t *r, const uint64_t *a,
+                             const uint64_t *b, const size_t n) {
+  const size_t head = n % 4;
+  uint64_t carry = 0;
+  for (size_t i = 0; i < head; i++) r[i] = add64(a[i], b[i], carry, carry);
+  size_t turns = n / 4;
+  if (turns == 0) return carry;
+
+  r += head;
+  a += head;
+  b += head;
+  uint64_t t0, t1;
+  __asm__("addq $-1, %[c]\n\t"
+          "1:\n\t"
+          "movq (%[a]), %[t0]\n\t"
+          "movq 8(%[a]), %[t1]\n\t"
+          "adcq (%[b]), %[t0]\n\t"
+          "adcq 8(%[b]), %[t1]\n\t"
+          "movq %[t0], (%[r])\n\t"
+          "movq %[t1], 8(%[r])\n\t"
+          "movq 16(%[a]), %[t0]\n\t"
+          "movq 24(%[a]), %[t1]\n\t"
+          "adcq 16(%[b]), %[t0]\n\t"
+          "adcq 24(%[b]), %[t1]\n\t"
+          "movq %[t0], 16(%[r])\n\t"
+          "movq %[t1], 24(%[r])\n\t"
+          "leaq 32(%[a]), %[a]\n\t"
+          "leaq 32(%[b]), %[b]\n\t"
+          "leaq 32(%[r]), %[r]\n\t"
+          "decq %[n]\n\t"
+          "jnz 1b\n\t"
+          "movl $0, %k[c]\n\t"
+          "setc %b[c]"
+          : [r] "+r"(r), [a] "+r"(a), [b] "+r"(b), [n] "+r"(turns),
+            [c] "+r"(carry), [t0] "=&r"(t0), [t1] "=&r"(t1)
+          :
+          : "cc", "memory");
+  return carry;
+}
+
+uint64_t internal::sub_n_x86(uint64_t *r, const uint64_t *a,
+                             const uint64_t *b, const size_t n) {
+  const size_t head = n % 4;
+  uint64_t borrow = 0;
+  for (size_t i = 0; i < head; i++) r[i] = sub64(a[i], b[i], borrow, borrow);
+  size_t turns = n / 4;
+  if (turns == 0) return borrow;
+
+  r += head;
+  a += head;
+  b += head;
+  uint64_t t0, t1;
+  __asm__("addq $-1, %[c]\n\t"
+          "1:\n\t"
+          "movq (%[a]), %[t0]\n\t"
+          "movq 8(%[a]), %[t1]\n\t"
+          "sbbq (%[b]), %[t0]\n\t"
+          "sbbq 8(%[b]), %[t1]\n\t"
+          "movq %[t0], (%[r])\n\t"
+          "movq %[t1], 8(%[r])\n\t"
+          "movq 16(%[a]), %[t0]\n\t"
+          "movq 24(%[a]), %[t1]\n\t"
+          "sbbq 16(%[b]), %[t0]\n\t"
+          "sbbq 24(%[b]), %[t1]\n\t"
+          "movq %[t0], 16(%[r])\n\t"
+          "movq %[t1], 24(%[r])\n\t"
+          "leaq 32(%[a]), %[a]\n\t"
+          "leaq 32(%[b]), %[b]\n\t"
+          "leaq 32(%[r]), %[r]\n\t"
+          "decq %[n]\n\t"
+          "jnz 1b\n\t"
+          "movl $0, %k[c]\n\t"
+          "setc %b[c]"
+          : [r] "+r"(r), [a] "+r"(a), [b] "+r"(b), [n] "+r"(turns),
+            [c] "+r"(borrow), [t0] "=&r"(t0), [t1] "=&r"(t1)
+          :
+          : "cc", "memory");
+  return borrow;
+}
+
+// r = a * b + carry: mulx leaves the flags alone, so one adc chain folds
+// each high limb into the next low one. lea and jrcxz count the turns
+// without touching CF.
+static uint64_t mul_1_mulx(uint64_t *r, const uint64_t *a, const size_t n,
+                           const uint64_t b) {
+  const size_t head = n % 4;
+  uint64_t high, low, carry = 0;
+  for (size_t i = 0; i < head; i++) {
+    mul64(a[i], b, high, low);
+    r[i] = add64(low, carry, 0, carry);
+    carry += high;
+  }
+  size_t turns = n / 4;
+  if (turns == 0) return carry;
+
+  r += head;
+  a += head;
+  uint64_t l0, l1, h0;
+  __asm__("xorl %k[l0], %k[l0]\n\t" // clears CF
+          "1:\n\t"
+          "mulxq (%[a]), %[l0], %[h0]\n\t"
+          "adcq %[c], %[l0]\n\t"
+          "movq %[l0], (%[r])\n\t"
+          "mulxq 8(%[a]), %[l1], %[c]\n\t"
+          "adcq %[h0], %[l1]\n\t"
+          "movq %[l1], 8(%[r])\n\t"
+          "mulxq 16(%[a]), %[l0], %[h0]\n\t"
+          "adcq %[c], %[l0]\n\t"
+          "movq %[l0], 16(%[r])\n\t"
+          "mulxq 24(%[a]), %[l1], %[c]\n\t"
+          "adcq %[h0], %[l1]\n\t"
+          "movq %[l1], 24(%[r])\n\t"
+          "leaq 32(%[a]), %[a]\n\t"
+          "leaq 32(%[r]), %[r]\n\t"
+          "leaq -1(%[n]), %[n]\n\t"
+          "jrcxz 2f\n\t"
+          "jmp 1b\n\t"
+          "2:\n\t"
+          "adcq $0, %[c]"
+          : [r] "+r"(r), [a] "+r"(a), [n] "+c"(turns), [c] "+r"(carry),
+            [l0] "=&r"(l0), [l1] "=&r"(l1), [h0] "=&r"(h0)
+          : "d"(b)
+          : "cc", "memory");
+  return carry;
+}
+
+// r += a * b: adox adds each high limb into the next low one on OF, adcx
+// adds that into r on CF, so the two carry chains run side by side.
+static uint64_t addmul_1_adx(uint64_t *r, const uint64_t *a, const size_t n,
+                             const uint64_t b) {
+  const size_t head = n % 4;
+  uint64_t high, low, carry = 0;
+  for (size_t i = 0; i < head; i++) {
+    mul64(a[i], b, high, low);
+    r[i] = add64(r[i], low, carry, carry);
+    carry += high;
+  }
+  size_t turns = n / 4;
+  if (turns == 0) return carry;
+
+  r += head;
+  a += head;
+  uint64_t l0, l1, h0;
+  __asm__("xorl %k[l0], %k[l0]\n\t" // clears CF and OF
+          "1:\n\t"
+          "mulxq (%[a]), %[l0], %[h0]\n\t"
+          "adoxq %[c], %[l0]\n\t"
+          "adcxq (%[r]), %[l0]\n\t"
+          "movq %[l0], (%[r])\n\t"
+          "mulxq 8(%[a]), %[l1], %[c]\n\t"
+          "adoxq %[h0], %[l1]\n\t"
+          "adcxq 8(%[r]), %[l1]\n\t"
+          "movq %[l1], 8(%[r])\n\t"
+          "mulxq 16(%[a]), %[l0], %[h0]\n\t"
+          "adoxq %[c], %[l0]\n\t"
+          "adcxq 16(%[r]), %[l0]\n\t"
+          "movq %[l0], 16(%[r])\n\t"
+          "mulxq 24(%[a]), %[l1], %[c]\n\t"
+          "adoxq %[h0], %[l1]\n\t"
+          "adcxq 24(%[r]), %[l1]\n\t"
+          "movq %[l1], 24(%[r])\n\t"
+          "leaq 32(%[a]), %[a]\n\t"
+          "leaq 32(%[r]), %[r]\n\t"
+          "leaq -1(%[n]), %[n]\n\t"
+          "jrcxz 2f\n\t"
+          "jmp 1b\n\t"
+          "2:\n\t"
+          "movl $0, %k[l0]\n\t"
+          "adoxq %[l0], %[c]\n\t"
+          "adcxq %[l0], %[c]"
+          : [r] "+r"(r), [a] "+r"(a), [n] "+c"(turns), [c] "+r"(carry),
+            [l0] "=&r"(l0), [l1] "=&r"(l1), [h0] "=&r"(h0)
+          : "d"(b)
+          : "cc", "memory");
+  return carry;
+}
+
+static LimbKernels detect() {
+  LimbKernels k = {nullptr, nullptr};
+  unsigned eax, ebx, ecx, edx;
+  if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return k;
+  const bool bmi2 = ebx >> 8 & 1, adx = ebx >> 19 & 1;
+  if (bmi2) k.mul_1 = mul_1_mulx;
+  if (bmi2 && adx) k.addmul_1 = addmul_1_adx;
+  return k;
+}
+
+const LimbKernels internal::limb_kernels = detect();
+#endif
+} // namespace lll
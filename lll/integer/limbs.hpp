@@ -0,0 +1,158 @@
+#ifndef LLL_INTEGER_LIMBS_HPP
+#define LLL_INTEGER_LIMBS_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+namespace lll {
+namespace internal {
+// heap buffers for LimbVec; cap may be rounded up. see pool.hpp.
+uint64_t *limb_alloc(size_t &cap);
+void limb_free(uint64_t *p, size_t cap);
+} // namespace internal
+
+// limb storage with a vector-like interface. up to INLINE limbs (256 bits,
+// enough for a product of two 128-bit values) live inside the object, larger
+// values go to the heap, through a LimbPool when one is active. data_ always
+// points at the live buffer, so element access never branches on where that
+// is.
+class LimbVec {
+public:
+  static constexpr size_t INLINE = 4;
+
+  LimbVec() noexcept : data_(local_), size_(0), cap_(INLINE) {}
+
+  explicit LimbVec(const size_t n) : LimbVec(n, 0) {}
+
+  LimbVec(const size_t n, const uint64_t value) : LimbVec() {
+    assign(n, value);
+  }
+
+  LimbVec(const LimbVec &other) : LimbVec() {
+    reserve(other.size_);
+    std::copy(other.begin(), other.end(), data_);
+    size_ = other.size_;
+  }
+
+  LimbVec(LimbVec &&other) noexcept : LimbVec() { steal(other); }
+
+  ~LimbVec() { release(); }
+
+  LimbVec &operator=(const LimbVec &other) {
+    if (this == &other) return *this;
+    size_ = 0;
+    reserve(other.size_);
+    std::copy(other.begin(), other.end(), data_);
+    size_ = other.size_;
+    return *this;
+  }
+
+  LimbVec &operator=(LimbVec &&other) noexcept {
+    if (this == &other) return *this;
+    release();
+    steal(other);
+    return *this;
+  }
+
+  size_t size() const { return size_; }
+  size_t capacity() const { return cap_; }
+  bool empty() const { return size_ == 0; }
+
+  uint64_t *data() { return data_; }
+  const uint64_t *data() const { return data_; }
+  uint64_t *begin() { return data_; }
+  const uint64_t *begin() const { return data_; }
+  uint64_t *end() { return data_ + size_; }
+  const uint64_t *end() const { return data_ + size_; }
+
+  uint64_t &operator[](const size_t i) { return data_[i]; }
+  const uint64_t &operator[](const size_t i) const { return data_[i]; }
+  uint64_t &front() { return data_[0]; }
+  const uint64_t &front() const { return data_[0]; }
+  uint64_t &back() { return data_[size_ - 1]; }
+  const uint64_t &back() const { return data_[size_ - 1]; }
+
+  uint64_t &at(const size_t i) {
+    if (i >= size_) throw std::out_of_range("LimbVec::at");
+    return data_[i];
+  }
+
+  const uint64_t &at(const size_t i) const {
+    if (i >= size_) throw std::out_of_range("LimbVec::at");
+    return data_[i];
+  }
+
+  void reserve(const size_t n) {
+    if (n <= cap_) return;
+    size_t cap = std::max(n, 2 * cap_);
+    uint64_t *p = internal::limb_alloc(cap);
+    std::copy(begin(), end(), p);
+    release();
+    data_ = p;
+    cap_ = cap;
+  }
+
+  // new limbs are zero, as with std::vector
+  void resize(const size_t n) {
+    reserve(n);
+    if (n > size_) std::fill(data_ + size_, data_ + n, 0);
+    size_ = n;
+  }
+
+  void assign(const size_t n, const uint64_t value) {
+    size_ = 0;
+    reserve(n);
+    std::fill(data_, data_ + n, value);
+    size_ = n;
+  }
+
+  // [first, last) must not point into this vector
+  void assign(const uint64_t *first, const uint64_t *last) {
+    size_ = 0;
+    reserve(last - first);
+    std::copy(first, last, data_);
+    size_ = last - first;
+  }
+
+  void clear() { size_ = 0; }
+
+  void push_back(const uint64_t value) {
+    if (size_ == cap_) reserve(size_ + 1);
+    data_[size_++] = value;
+  }
+
+  void pop_back() { size_--; }
+
+private:
+  bool local() const { return data_ == local_; }
+
+  void release() {
+    if (!local()) internal::limb_free(data_, cap_);
+    data_ = local_;
+    cap_ = INLINE;
+  }
+
+  // takes the heap buffer of other, or copies its inline limbs; other is
+  // left empty and inline.
+  void steal(LimbVec &other) {
+    if (other.local()) {
+      std::copy(other.begin(), other.end(), local_);
+    } else {
+      data_ = other.data_;
+      cap_ = other.cap_;
+      other.data_ = other.local_;
+      other.cap_ = INLINE;
+    }
+    size_ = other.size_;
+    other.size_ = 0;
+  }
+
+  uint64_t *data_;
+  size_t size_, cap_;
+  uint64_t local_[INLINE];
+};
+} // namespace lll
+
+#endif // LLL_INTEGER_LIMBS_HPP
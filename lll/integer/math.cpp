@@ -1,24 +1,30 @@
 #include "math.hpp"
+#include "internal.hpp"
+#include "modular.hpp"
 #include <stdexcept>
+#include <vector>
 
 namespace lll {
-static inline void swap(Integer *&px, Integer *&py) noexcept {
-  Integer *pt = px;
-  px = py;
-  py = pt;
-}
-
 Integer pow(const Integer &b, uint64_t e) {
-  Integer out = 1;
-  if (e == 0) return out;
-
-  Integer c = b;
-  while (true) {
-    if (e & 1) out *= c;
-    e /= 2;
-    if (e == 0) return out;
-    c *= c;
+  if (e == 0) return 1;
+
+  const uint64_t top = 63 - internal::clz64(e);
+  const uint64_t k = internal::window_bits(top + 1);
+  std::vector<Integer> table(1, b);
+  if (k > 1) {
+    Integer b2;
+    Integer::sqr(b, b2);
+    for (size_t j = 1; j < (size_t)1 << (k - 1); j++) {
+      table.push_back(table.back() * b2);
+    }
   }
+
+  Integer out;
+  internal::sliding_window(
+      &e, top, k, [&](const uint64_t j) { out = table[j]; },
+      [&] { Integer::sqr(out, out); },
+      [&](const uint64_t j) { out *= table[j]; });
+  return out;
 }
 
 Integer pow_mod(const Integer &b, const Integer &e, const Integer &m) {
@@ -31,24 +37,17 @@ Integer pow_mod(const Integer &b, const Integer &e, const Integer &m) {
   if (e.zero()) return 1;
   if (e.neg()) return b == 1 ? 1 : 0;
 
-  Integer out = 1;
-  Integer c = b % m;
-  const Integer::VecView &ev = e.view_v();
-  for (size_t i = 0; i < ev.size(); i++) {
-    uint64_t mask = ev[i];
-    for (size_t j = 0; j < 64; j++) {
-      // if (i == 1 && j == 61)
-      if (mask & 1) {
-        out *= c;
-        out %= m;
-      }
-      mask /= 2;
-      if (!mask && i == ev.size() - 1) break;
-      c *= c;
-      c %= m;
-    }
-  }
-  return out;
+  // the sign follows b ^ e, as with repeated Integer::mod
+  const bool neg = b.neg() && e.view_v()[0] & 1;
+  Integer c = b.abs() % m;
+  Integer out = m.view_v()[0] & 1 ? Montgomery(m).pow(c, e)
+                                  : Barrett(m).pow(c, e);
+  return neg ? -out : out;
+}
+
+Integer pow_mod_ct(const Integer &b, const Integer &e, const Integer &m) {
+  if (e.neg()) throw std::domain_error("e < 0.");
+  return Montgomery(m).pow_ct(b, e);
 }
 
 uint64_t log(const Integer &b, const Integer &x) {
@@ -61,8 +60,8 @@ uint64_t log(const Integer &b, const Integer &x) {
   std::vector<Integer> stack = {b};
 
   while (true) {
-    const Integer &y = stack.back();
-    Integer z = y * y;
+    Integer z;
+    Integer::sqr(stack.back(), z);
     if (z > x) break;
 
     out *= 2;
@@ -81,85 +80,4 @@ uint64_t log(const Integer &b, const Integer &x) {
   }
   return out;
 }
-
-Integer gcd(const Integer &a, const Integer &b) {
-  Integer ca = a.abs(), cb = b.abs(), c;
-  Integer *pa = &ca, *pb = &cb, *pc = &c;
-
-  while (true) {
-    Integer::mod(*pa, *pb, *pc);
-    if (pc->zero()) return std::move(*pb);
-
-    // a, b, c = b, c, a;
-    swap(pa, pb);
-    swap(pb, pc);
-  }
-}
-
-Integer sqrt(const Integer &n) {
-  if (n.neg()) throw std::domain_error("n < 0.");
-
-  Integer x = n;
-  Integer y = n + 1;
-  y /= 2;
-
-  Integer *px = &x, *py = &y;
-  while (*px > *py) {
-    // x = y;
-    swap(px, py);
-
-    // y = (x + n / x) // 2;
-    Integer::div(n, *px, *py);
-    *py += *px;
-    *py /= 2;
-  }
-  return std::move(*px);
-}
-
-bool is_prime(const Integer &n) {
-  if (n < 2) return false;
-  if (n < 4) return true;
-
-  Integer rem = n % 2;
-  if (rem.zero()) return false;
-
-  const Integer sqrt_n = sqrt(n);
-  for (Integer m = 3; m <= sqrt_n; m += 2) {
-    Integer::mod(n, m, rem);
-    if (rem.zero()) return false;
-  }
-  return true;
-}
-
-static bool prime_test_step(const Integer &n, const Integer &m,
-                            const Integer &d, const uint64_t s) {
-  const Integer a = Integer::random(n - 4) + 2;
-  Integer x = pow_mod(a, d, n);
-  if (x.zero()) return false;
-  if (x == 1 || x == m) return true;
-
-  for (uint64_t i = 1; i < s; i++) {
-    x *= x;
-    x %= n;
-    if (x == m) return true;
-    if (x.zero() || x == 1) return false;
-  }
-  return false;
-}
-
-bool prime_test(const Integer &n, size_t t) {
-  if (n < 2) return false;
-  if (n < 4) return true;
-
-  const Integer m = n - 1;
-  const uint64_t s = m.pow_of_2();
-  if (s == 0) return false;
-  const Integer d = m >> s;
-
-  while (t--) {
-    if (!prime_test_step(n, m, d, s)) return false;
-  }
-  return true;
-}
-
 } // namespace lll
\ No newline at end of file
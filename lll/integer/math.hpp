@@ -6,11 +6,38 @@
 namespace lll {
 Integer pow(const Integer &b, uint64_t e);
 Integer pow_mod(const Integer &b, const Integer &e, const Integer &m);
+// b ^ e mod m in [0, m) for odd m > 1, with timing independent of the bits
+// of e (fixed windows, no secret dependent branches or table indexing)
+Integer pow_mod_ct(const Integer &b, const Integer &e, const Integer &m);
 uint64_t log(const Integer &b, const Integer &x);
 Integer gcd(const Integer &a, const Integer &b);
+// g = gcd(a, b) = s * a + t * b, with |s| <= |b| / (2g) and |t| <= |a| / g
+// unless a or b is zero
+Integer gcdext(const Integer &a, const Integer &b, Integer &s,
+               Integer *t = nullptr);
+// a ^ -1 mod m in [0, m), m > 1; throws if gcd(a, m) != 1
+Integer invert(const Integer &a, const Integer &m);
 Integer sqrt(const Integer &n);
+// s = floor(sqrt(n)) with rem = n - s ^ 2, n >= 0
+Integer sqrtrem(const Integer &n, Integer &rem);
+// floor(n ^ (1 / k)) for k > 0, rounded towards zero; n < 0 needs k odd
+Integer root(const Integer &n, uint64_t k);
+// n = a ^ k for some a and k > 1
+bool is_perfect_power(const Integer &n);
+// baillie-psw after screening by small primes; exact below 2^64, and no
+// composite is known to pass above
+bool is_probable_prime(const Integer &n);
+// exact below 2^64; above that probabilistic, the same as is_probable_prime
 bool is_prime(const Integer &n);
-bool prime_test(const Integer &n, size_t t = 1);
+// the least prime above n; threads as for prime_test
+Integer next_prime(const Integer &n, size_t threads = 1);
+// a random prime of exactly bits bits, bits > 1. above a word it is the
+// first prime after a random start, which favours primes after long gaps a
+// little, as usual for this search.
+Integer random_prime(uint64_t bits, size_t threads = 1);
+// miller-rabin with t random bases, on up to threads threads (0: one per
+// core); the rounds still queued or running stop once one finds a witness
+bool prime_test(const Integer &n, size_t t = 1, size_t threads = 1);
 }
 
 #endif // LLL_INTEGER_MATH_HPP
\ No newline at end of file
@@ -0,0 +1,258 @@
+#include "modular.hpp"
+#include "internal.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+namespace lll {
+using namespace internal;
+
+// r = t - m if t >= m else t, t has n + 1 limbs and t < 2m. branch free,
+// so the constant time exponentiation can use it.
+static void mont_final_sub(uint64_t *r, const uint64_t *t, const uint64_t *m,
+                           const size_t n) {
+  uint64_t borrow = 0;
+  for (size_t i = 0; i < n; i++) r[i] = sub64(t[i], m[i], borrow, borrow);
+  // t[n] == 1 implies the borrow; keep t only for t[n] == 0 and a borrow
+  const uint64_t keep = 0 - (borrow & ~t[n] & 1);
+  for (size_t i = 0; i < n; i++) r[i] = (r[i] & ~keep) | (t[i] & keep);
+}
+
+// r = a * b / B^n mod m, a, b < m; t is 2n + 2 limbs of scratch.
+// coarsely integrated operand scanning: each outer step adds the rows
+// a[i] * b and u * m, u chosen to clear the low limb, and moves up a limb,
+// so the sum slides along t instead of being shifted. the rows are
+// addmul_1, so they run on the carry-chain kernels.
+static void mont_mul_(uint64_t *r, const uint64_t *a, const uint64_t *b,
+                      const uint64_t *m, const size_t n, const uint64_t m_inv,
+                      uint64_t *t) {
+  std::fill(t, t + 2 * n + 2, 0);
+  for (size_t i = 0; i < n; i++, t++) {
+    uint64_t carry;
+    t[n] = add64(t[n], addmul_1(t, b, n, a[i]), 0, carry);
+    t[n + 1] += carry;
+    t[n] = add64(t[n], addmul_1(t, m, n, t[0] * m_inv), 0, carry);
+    t[n + 1] += carry;
+  }
+  mont_final_sub(r, t, m, n);
+}
+
+// r = t / B^n mod m for t < m * B^n of 2n limbs; t needs 2n + 1 limbs and
+// is clobbered.
+static void mont_redc_(uint64_t *r, uint64_t *t, const uint64_t *m,
+                       const size_t n, const uint64_t m_inv) {
+  t[2 * n] = 0;
+  for (size_t i = 0; i < n; i++) {
+    const uint64_t carry = addmul_1(t + i, m, n, t[i] * m_inv);
+    add_1(t + i + n, n + 1 - i, carry);
+  }
+  mont_final_sub(r, t + n, m, n);
+}
+
+// r = a * a / B^n mod m; t is 2n + 1 limbs of scratch.
+static void mont_sqr_(uint64_t *r, const uint64_t *a, const uint64_t *m,
+                      const size_t n, const uint64_t m_inv, uint64_t *t) {
+  usqr_(t, a, n);
+  mont_redc_(r, t, m, n, m_inv);
+}
+
+// |a| zero-extended to n limbs, a < B^n
+static void load(const Integer &a, const size_t n, VecU64 &out) {
+  const VecU64 &v = a.view_v();
+  out.assign(n, 0);
+  std::copy(v.begin(), v.end(), out.begin());
+}
+
+Montgomery::Montgomery(const Integer &m) : m_(m), m_inv_(0) {
+  if (m <= 1 || m.view_v()[0] % 2 == 0) {
+    throw std::domain_error("m must be odd and > 1.");
+  }
+  const size_t n = m.view_v().size();
+  m_inv_ = -inv64(m.view_v()[0]);
+  r2_ = (Integer(1) << 128 * n) % m;
+}
+
+Integer Montgomery::to_mont(const Integer &a) const {
+  Integer c = a % m_;
+  if (c.neg()) c += m_;
+  return mul(c, r2_);
+}
+
+Integer Montgomery::from_mont(const Integer &a) const { return mul(a, 1); }
+
+Integer Montgomery::mul(const Integer &a, const Integer &b) const {
+  const size_t n = m_.abs_val_.size();
+  VecU64 va, vb, t(2 * n + 2), res(n);
+  load(a, n, va);
+  load(b, n, vb);
+  mont_mul_(res.data(), va.data(), vb.data(), m_.abs_val_.data(), n, m_inv_,
+            t.data());
+  norm(res);
+  return {false, std::move(res)};
+}
+
+Integer Montgomery::sqr(const Integer &a) const {
+  const size_t n = m_.abs_val_.size();
+  VecU64 va, t(2 * n + 1), res(n);
+  load(a, n, va);
+  mont_sqr_(res.data(), va.data(), m_.abs_val_.data(), n, m_inv_, t.data());
+  norm(res);
+  return {false, std::move(res)};
+}
+
+Integer Montgomery::pow(const Integer &b, const Integer &e) const {
+  return pow_(b, e, nullptr);
+}
+
+Integer Montgomery::pow(const Integer &b, const Integer &e,
+                        const std::atomic<bool> &stop) const {
+  return pow_(b, e, &stop);
+}
+
+// once stop is set, the steps left do nothing and the scan runs out
+Integer Montgomery::pow_(const Integer &b, const Integer &e,
+                         const std::atomic<bool> *stop) const {
+  if (e.neg()) throw std::domain_error("e < 0.");
+  if (e.zero()) return 1;
+
+  const size_t n = m_.abs_val_.size();
+  const uint64_t *m = m_.abs_val_.data();
+  const uint64_t top = e.abs_log2();
+  const uint64_t k = window_bits(top + 1);
+  VecU64 x, t(2 * n + 2);
+
+  // odd powers b, b^3, ..., b^(2^k - 1)
+  VecU64 table(n << (k - 1));
+  load(to_mont(b), n, x);
+  std::copy(x.begin(), x.end(), table.begin());
+  if (k > 1) {
+    mont_sqr_(x.data(), x.data(), m, n, m_inv_, t.data());
+    for (size_t j = 1; j < (size_t)1 << (k - 1); j++) {
+      mont_mul_(&table[j * n], &table[(j - 1) * n], x.data(), m, n, m_inv_,
+                t.data());
+    }
+  }
+
+  const auto stopped = [stop] {
+    return stop && stop->load(std::memory_order_relaxed);
+  };
+  sliding_window(
+      e.view_v().data(), top, k,
+      [&](const uint64_t j) {
+        std::copy(&table[j * n], &table[j * n] + n, x.begin());
+      },
+      [&] {
+        if (!stopped()) mont_sqr_(x.data(), x.data(), m, n, m_inv_, t.data());
+      },
+      [&](const uint64_t j) {
+        if (stopped()) return;
+        mont_mul_(x.data(), x.data(), &table[j * n], m, n, m_inv_, t.data());
+      });
+
+  // from montgomery form: multiply by plain 1
+  VecU64 one(n, 0);
+  one[0] = 1;
+  mont_mul_(x.data(), x.data(), one.data(), m, n, m_inv_, t.data());
+  norm(x);
+  return {false, std::move(x)};
+}
+
+Integer Montgomery::pow_ct(const Integer &b, const Integer &e) const {
+  if (e.neg()) throw std::domain_error("e < 0.");
+
+  const size_t n = m_.abs_val_.size();
+  const uint64_t *m = m_.abs_val_.data();
+  const VecU64 &ev = e.view_v();
+  const uint64_t bits = 64 * ev.size();
+  const uint64_t k = std::min<uint64_t>(window_bits(bits), 6);
+  const size_t size = (size_t)1 << k;
+  VecU64 x, sel(n), t(2 * n + 2), table(n * size);
+
+  // all powers b^0 .. b^(2^k - 1)
+  load(to_mont(b), n, x);
+  std::copy(x.begin(), x.end(), &table[n]);
+  load(to_mont(1), n, x);
+  std::copy(x.begin(), x.end(), &table[0]);
+  for (size_t j = 2; j < size; j++) {
+    mont_mul_(&table[j * n], &table[(j - 1) * n], &table[n], m, n, m_inv_,
+              t.data());
+  }
+
+  // fixed k-bit digits from the top; only the limb count of e shows in the
+  // trip count, squarings go through the branch free CIOS kernel and every
+  // table entry is read for each digit.
+  for (uint64_t pos = (bits + k - 1) / k * k; pos;) {
+    pos -= k;
+    uint64_t d = ev[pos / 64] >> (pos % 64);
+    if (pos % 64 + k > 64 && pos / 64 + 1 < ev.size()) {
+      d |= ev[pos / 64 + 1] << (64 - pos % 64);
+    }
+    d &= size - 1;
+
+    for (uint64_t i = 0; i < k; i++) {
+      mont_mul_(x.data(), x.data(), x.data(), m, n, m_inv_, t.data());
+    }
+    std::fill(sel.begin(), sel.end(), 0);
+    for (size_t j = 0; j < size; j++) {
+      const uint64_t mask = 0 - (uint64_t)(j == d);
+      for (size_t i = 0; i < n; i++) sel[i] |= table[j * n + i] & mask;
+    }
+    mont_mul_(x.data(), x.data(), sel.data(), m, n, m_inv_, t.data());
+  }
+
+  VecU64 one(n, 0);
+  one[0] = 1;
+  mont_mul_(x.data(), x.data(), one.data(), m, n, m_inv_, t.data());
+  norm(x);
+  return {false, std::move(x)};
+}
+
+Barrett::Barrett(const Integer &m) : m_(m), shift_(0) {
+  if (m <= 1) throw std::domain_error("m <= 1.");
+  const size_t n = m.view_v().size();
+  shift_ = 64 * (n - 1);
+  mu_ = (Integer(1) << 128 * n) / m;
+}
+
+Integer Barrett::reduce(const Integer &x) const {
+  Integer q = x >> shift_;
+  q *= mu_;
+  q >>= shift_ + 128;
+  q *= m_;
+
+  Integer r = x - q;
+  while (r >= m_) r -= m_;
+  return r;
+}
+
+Integer Barrett::mul(const Integer &a, const Integer &b) const {
+  return reduce(a * b);
+}
+
+Integer Barrett::sqr(const Integer &a) const {
+  Integer out;
+  Integer::sqr(a, out);
+  return reduce(out);
+}
+
+Integer Barrett::pow(const Integer &b, const Integer &e) const {
+  if (e.neg()) throw std::domain_error("e < 0.");
+  if (e.zero()) return 1;
+
+  const uint64_t top = e.abs_log2();
+  const uint64_t k = window_bits(top + 1);
+  std::vector<Integer> table(1, b);
+  if (k > 1) {
+    const Integer b2 = sqr(b);
+    for (size_t j = 1; j < (size_t)1 << (k - 1); j++) {
+      table.push_back(mul(table.back(), b2));
+    }
+  }
+
+  Integer x;
+  sliding_window(
+      e.view_v().data(), top, k, [&](const uint64_t j) { x = table[j]; },
+      [&] { x = sqr(x); }, [&](const uint64_t j) { x = mul(x, table[j]); });
+  return x;
+}
+} // namespace lll
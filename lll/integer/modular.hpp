@@ -0,0 +1,67 @@
+#ifndef LLL_INTEGER_MODULAR_HPP
+#define LLL_INTEGER_MODULAR_HPP
+
+#include "../integer.hpp"
+#include <atomic>
+
+namespace lll {
+// arithmetic modulo an odd m > 1 in montgomery form x * R mod m, where
+// R = 2^(64 * limbs of m). build once, reuse for every operation mod m.
+class Montgomery {
+public:
+  explicit Montgomery(const Integer &m);
+
+  const Integer &modulus() const { return m_; }
+
+  // plain a (any sign or size) -> montgomery form
+  Integer to_mont(const Integer &a) const;
+  // montgomery form -> plain, in [0, m)
+  Integer from_mont(const Integer &a) const;
+  // a * b / R mod m, a and b in [0, m)
+  Integer mul(const Integer &a, const Integer &b) const;
+  // a * a / R mod m, a in [0, m)
+  Integer sqr(const Integer &a) const;
+  // b ^ e mod m, plain in and out, e >= 0
+  Integer pow(const Integer &b, const Integer &e) const;
+  // pow giving up once stop is set, with an unspecified result: for work
+  // raced on several threads
+  Integer pow(const Integer &b, const Integer &e,
+              const std::atomic<bool> &stop) const;
+  // pow with fixed windows, whose timing depends on the limb count of e but
+  // not on its bits
+  Integer pow_ct(const Integer &b, const Integer &e) const;
+
+private:
+  Integer pow_(const Integer &b, const Integer &e,
+               const std::atomic<bool> *stop) const;
+
+  Integer m_;
+  Integer r2_;     // R^2 mod m
+  uint64_t m_inv_; // -m^-1 mod 2^64
+};
+
+// arithmetic modulo any m > 1 through barrett reduction with
+// mu = floor(2^(128 * limbs of m) / m); used for even moduli.
+class Barrett {
+public:
+  explicit Barrett(const Integer &m);
+
+  const Integer &modulus() const { return m_; }
+
+  // x mod m, 0 <= x < m^2
+  Integer reduce(const Integer &x) const;
+  // a * b mod m, a and b in [0, m)
+  Integer mul(const Integer &a, const Integer &b) const;
+  // a * a mod m, a in [0, m)
+  Integer sqr(const Integer &a) const;
+  // b ^ e mod m, b in [0, m), e >= 0
+  Integer pow(const Integer &b, const Integer &e) const;
+
+private:
+  Integer m_;
+  Integer mu_;
+  uint64_t shift_; // 64 * (limbs of m - 1)
+};
+} // namespace lll
+
+#endif // LLL_INTEGER_MODULAR_HPP
@@ -0,0 +1,86 @@
+#include "mpn.hpp"
+#include "internal.hpp"
+#include <algorithm>
+
+namespace lll {
+uint64_t mpn::add_n(uint64_t *r, const uint64_t *a, const uint64_t *b,
+                    const size_t n) {
+  return internal::add_n(r, a, b, n);
+}
+
+uint64_t mpn::sub_n(uint64_t *r, const uint64_t *a, const uint64_t *b,
+                    const size_t n) {
+  return internal::sub_n(r, a, b, n);
+}
+
+uint64_t mpn::add_1(uint64_t *r, const uint64_t *a, const size_t n,
+                    const uint64_t b) {
+  if (r != a) std::copy(a, a + n, r);
+  return internal::add_1(r, n, b);
+}
+
+uint64_t mpn::sub_1(uint64_t *r, const uint64_t *a, const size_t n,
+                    const uint64_t b) {
+  if (r != a) std::copy(a, a + n, r);
+  return internal::sub_1(r, n, b);
+}
+
+uint64_t mpn::mul_1(uint64_t *r, const uint64_t *a, const size_t n,
+                    const uint64_t b) {
+  return internal::mul_1(r, a, n, b);
+}
+
+uint64_t mpn::addmul_1(uint64_t *r, const uint64_t *a, const size_t n,
+                       const uint64_t b) {
+  return internal::addmul_1(r, a, n, b);
+}
+
+uint64_t mpn::submul_1(uint64_t *r, const uint64_t *a, const size_t n,
+                       const uint64_t b) {
+  return internal::submul_1(r, a, n, b);
+}
+
+uint64_t mpn::lshift(uint64_t *r, const uint64_t *a, const size_t n,
+                     const unsigned s) {
+  return internal::lshift(r, a, n, s);
+}
+
+uint64_t mpn::rshift(uint64_t *r, const uint64_t *a, const size_t n,
+                     const unsigned s) {
+  return internal::rshift(r, a, n, s);
+}
+
+int mpn::cmp(const uint64_t *a, const uint64_t *b, const size_t n) {
+  return internal::cmp_n(a, b, n);
+}
+
+size_t mpn::normalize(const uint64_t *a, const size_t n) {
+  return internal::norm_size(a, n);
+}
+
+size_t mpn::mul_itch(const size_t n) { return internal::mul_itch(n); }
+
+void mpn::mul(uint64_t *r, const uint64_t *a, const size_t na,
+              const uint64_t *b, const size_t nb, uint64_t *scratch) {
+  internal::umul_(r, a, na, b, nb, scratch);
+}
+
+void mpn::sqr(uint64_t *r, const uint64_t *a, const size_t n,
+              uint64_t *scratch) {
+  internal::usqr_(r, a, n, scratch);
+}
+
+uint64_t mpn::divrem_1(uint64_t *q, const uint64_t *a, const size_t n,
+                       const uint64_t d) {
+  return internal::divrem_1_(q, a, n, d);
+}
+
+size_t mpn::divrem_itch(const size_t na, const size_t nd) {
+  return internal::divrem_itch(na, nd);
+}
+
+void mpn::divrem(uint64_t *q, uint64_t *r, const uint64_t *a, const size_t na,
+                 const uint64_t *d, const size_t nd, uint64_t *scratch) {
+  internal::divrem_(q, r, a, na, d, nd, scratch);
+}
+} // namespace lll
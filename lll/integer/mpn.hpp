@@ -0,0 +1,65 @@
+#ifndef LLL_INTEGER_MPN_HPP
+#define LLL_INTEGER_MPN_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace lll {
+// low-level natural number arithmetic on raw limb arrays: little-endian
+// uint64_t, lengths n in limbs, no allocation. results go to caller memory;
+// the functions that need temporary space take a scratch pointer sized by
+// the matching *_itch function. unless noted, r may be the same pointer as
+// an input of the same length, but must not partially overlap one.
+//
+// these are the kernels Integer is built on; Integer::view_v() exposes the
+// limbs of a value to feed them.
+namespace mpn {
+// r = a + b, returns the carry (0 or 1).
+uint64_t add_n(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t n);
+// r = a - b, returns the borrow (0 or 1).
+uint64_t sub_n(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t n);
+// r = a + b for a single limb b, returns the carry.
+uint64_t add_1(uint64_t *r, const uint64_t *a, size_t n, uint64_t b);
+// r = a - b for a single limb b, returns the borrow.
+uint64_t sub_1(uint64_t *r, const uint64_t *a, size_t n, uint64_t b);
+// r = a * b, returns the high limb.
+uint64_t mul_1(uint64_t *r, const uint64_t *a, size_t n, uint64_t b);
+// r += a * b, returns the carry limb. r must not overlap a.
+uint64_t addmul_1(uint64_t *r, const uint64_t *a, size_t n, uint64_t b);
+// r -= a * b, returns the borrow limb. r must not overlap a.
+uint64_t submul_1(uint64_t *r, const uint64_t *a, size_t n, uint64_t b);
+// r = a << s, 0 < s < 64, returns the bits shifted out at the top.
+uint64_t lshift(uint64_t *r, const uint64_t *a, size_t n, unsigned s);
+// r = a >> s, 0 < s < 64, returns the bits shifted out, in the top of the
+// limb.
+uint64_t rshift(uint64_t *r, const uint64_t *a, size_t n, unsigned s);
+// sign of a - b
+int cmp(const uint64_t *a, const uint64_t *b, size_t n);
+// n less the high zero limbs of a
+size_t normalize(const uint64_t *a, size_t n);
+
+// scratch limbs for mul and sqr with operands of up to n limbs.
+size_t mul_itch(size_t n);
+// r[0, na + nb) = a * b, na >= nb > 0. r must not overlap a or b. very
+// large products (number theoretic transform tier) still take their buffers
+// from a per-thread cache.
+void mul(uint64_t *r, const uint64_t *a, size_t na, const uint64_t *b,
+         size_t nb, uint64_t *scratch);
+// r[0, 2n) = a * a, n > 0. r must not overlap a.
+void sqr(uint64_t *r, const uint64_t *a, size_t n, uint64_t *scratch);
+
+// q[0, n) = a / d, returns a % d, d != 0. q may be a; q may be null.
+uint64_t divrem_1(uint64_t *q, const uint64_t *a, size_t n, uint64_t d);
+// scratch limbs for divrem.
+size_t divrem_itch(size_t na, size_t nd);
+// q[0, na - nd + 1) = a / d, r[0, nd) = a % d, na >= nd > 0 and the top limb
+// of d non-zero; the top limbs of q and r may be zero. q or r may be null,
+// or the same pointer as a or d, but must not overlap each other or the
+// scratch. as for mul, products in the transform tier, which large divisors
+// reach, take their own buffers.
+void divrem(uint64_t *q, uint64_t *r, const uint64_t *a, size_t na,
+            const uint64_t *d, size_t nd, uint64_t *scratch);
+} // namespace mpn
+} // namespace lll
+
+#endif // LLL_INTEGER_MPN_HPP
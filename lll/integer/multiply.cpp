@@ -1,4 +1,6 @@
 #include "internal.hpp"
+#include "tuning.hpp"
+#include <algorithm>
 
 namespace lll {
 using namespace internal;
@@ -17,22 +19,349 @@ void internal::umul_64bits_(const VecU64 &a, const uint64_t b, VecU64 &out) {
   else out.pop_back();
 }
 
-static void grade_school(const VecU64 &a, const VecU64 &b, VecU64 &out) {
-  const size_t size_a = a.size();
-  const size_t size_b = b.size();
-  VecU64 res(size_a + size_b, 0);
+static void grade_school(uint64_t *r, const uint64_t *a, const size_t na,
+                         const uint64_t *b, const size_t nb) {
+  r[na] = mul_1(r, a, na, b[0]);
+  for (size_t j = 1; j < nb; j++) r[j + na] = addmul_1(r + j, a, na, b[j]);
+}
 
-  for (size_t i = 0; i < size_a; i++) {
-    uint64_t high, low, carry = 0;
-    for (size_t j = 0; j < size_b; j++) {
-      mul64(a[i], b[j], high, low);
-      res[i + j] = add64(res[i + j], low, carry, carry);
-      carry += high;
+// each cross product a[i] * a[j], i < j, is computed once and doubled.
+static void sqr_school(uint64_t *r, const uint64_t *a, const size_t n) {
+  r[0] = 0;
+  r[2 * n - 1] = 0;
+  if (n > 1) {
+    r[n] = mul_1(r + 1, a + 1, n - 1, a[0]);
+    for (size_t i = 1; i + 1 < n; i++) {
+      r[i + n] = addmul_1(r + 2 * i + 1, a + i + 1, n - i - 1, a[i]);
     }
-    res[i + size_b] = carry;
   }
-  norm_top(res);
-  out = std::move(res);
+  for (size_t i = 2 * n; i--;) r[i] = r[i] << 1 | (i ? r[i - 1] >> 63 : 0);
+
+  uint64_t high, low, carry = 0;
+  for (size_t i = 0; i < n; i++) {
+    mul64(a[i], a[i], high, low);
+    r[2 * i] = add64(r[2 * i], low, carry, carry);
+    r[2 * i + 1] = add64(r[2 * i + 1], high, carry, carry);
+  }
+}
+
+size_t internal::mul_itch(const size_t n) {
+  size_t depth = 1;
+  for (size_t m = n; m > 1; m /= 2) depth++;
+  return 8 * n + 32 * depth;
+}
+
+static void umul_rec(uint64_t *r, const uint64_t *a, size_t na,
+                     const uint64_t *b, size_t nb, uint64_t *tmp);
+static void usqr_rec(uint64_t *r, const uint64_t *a, size_t n, uint64_t *tmp);
+
+// |a - b| where a has n limbs, b has m <= n limbs; returns true if a < b.
+static bool abs_sub(uint64_t *r, const uint64_t *a, const size_t n,
+                    const uint64_t *b, const size_t m) {
+  size_t i = n;
+  while (i > m && a[i - 1] == 0) i--;
+  bool less = false;
+  if (i == m) {
+    while (i-- && a[i] == b[i]);
+    less = i != SIZE_MAX && a[i] < b[i];
+  }
+  if (less) {
+    // a < b, so the limbs of a above m are all zero
+    sub_n(r, b, a, m);
+    std::fill(r + m, r + n, 0);
+  } else {
+    const uint64_t borrow = sub_n(r, a, b, m);
+    std::copy(a + m, a + n, r + m);
+    sub_1(r + m, n - m, borrow);
+  }
+  return less;
+}
+
+// splits the longer operand into nb-limb chunks, na >= nb.
+static void umul_chunked(uint64_t *r, const uint64_t *a, size_t na,
+                         const uint64_t *b, const size_t nb, uint64_t *tmp) {
+  uint64_t *prod = tmp;
+  tmp += 2 * nb;
+
+  umul_rec(r, a, nb, b, nb, tmp);
+  for (size_t done = nb; done < na; done += nb) {
+    const size_t len = std::min(nb, na - done);
+    if (len == nb) umul_rec(prod, a + done, nb, b, nb, tmp);
+    else umul_rec(prod, b, nb, a + done, len, tmp);
+
+    // r[done, done + nb) holds the top of the previous chunk
+    std::copy(prod + nb, prod + nb + len, r + done + nb);
+    const uint64_t carry = add_n(r + done, r + done, prod, nb);
+    add_1(r + done + nb, len, carry);
+  }
+}
+
+// r holds z0 = a0 * b0 in [0, 2k) and z2 = a1 * b1 in [2k, 2k + nz2);
+// adds (z0 + z2 -+ zm) * B^k, using t (2k + 1 limbs) as scratch.
+static void karatsuba_combine(uint64_t *r, const size_t n, const size_t k,
+                              const size_t nz2, const uint64_t *zm,
+                              const bool sub, uint64_t *t) {
+  // never negative
+  std::copy(r, r + 2 * k, t);
+  t[2 * k] = add_1(t + nz2, 2 * k - nz2, add_n(t, t, r + 2 * k, nz2));
+  if (sub) t[2 * k] -= sub_n(t, t, zm, 2 * k);
+  else t[2 * k] += add_n(t, t, zm, 2 * k);
+
+  const size_t rest = n - k;
+  const size_t len = std::min(2 * k + 1, rest);
+  const uint64_t carry = add_n(r + k, r + k, t, len);
+  add_1(r + k + len, rest - len, carry);
+}
+
+// a = a0 + a1 * B^k, b = b0 + b1 * B^k, nb > k = ceil(na / 2)
+// a * b = z0 + (z0 + z2 - (a0 - a1)(b0 - b1)) * B^k + z2 * B^2k
+static void karatsuba(uint64_t *r, const uint64_t *a, const size_t na,
+                      const uint64_t *b, const size_t nb, uint64_t *tmp) {
+  const size_t k = (na + 1) / 2;
+  const size_t na1 = na - k, nb1 = nb - k;
+
+  uint64_t *da = tmp, *db = da + k, *zm = db + k, *t = zm + 2 * k;
+  tmp = t + 2 * k + 1;
+
+  const bool neg_a = abs_sub(da, a, k, a + k, na1);
+  const bool neg_b = abs_sub(db, b, k, b + k, nb1);
+  umul_rec(zm, da, k, db, k, tmp);
+
+  umul_rec(r, a, k, b, k, tmp);
+  if (na1 >= nb1) umul_rec(r + 2 * k, a + k, na1, b + k, nb1, tmp);
+  else umul_rec(r + 2 * k, b + k, nb1, a + k, na1, tmp);
+
+  karatsuba_combine(r, na + nb, k, na1 + nb1, zm, neg_a == neg_b, t);
+}
+
+static void karatsuba_sqr(uint64_t *r, const uint64_t *a, const size_t n,
+                          uint64_t *tmp) {
+  const size_t k = (n + 1) / 2;
+  const size_t n1 = n - k;
+
+  uint64_t *da = tmp, *zm = da + k, *t = zm + 2 * k;
+  tmp = t + 2 * k + 1;
+
+  abs_sub(da, a, k, a + k, n1);
+  usqr_rec(zm, da, k, tmp);
+  usqr_rec(r, a, k, tmp);
+  usqr_rec(r + 2 * k, a + k, n1, tmp);
+  karatsuba_combine(r, 2 * n, k, 2 * n1, zm, true, t);
+}
+
+// two's complement helpers on w-limb signed values, used by toom3.
+
+// x -= y, y unsigned with n <= w limbs.
+static void sub_tc(uint64_t *x, const size_t w, const uint64_t *y,
+                   const size_t n) {
+  sub_1(x + n, w - n, sub_n(x, x, y, n));
+}
+
+static void neg_tc(uint64_t *x, const size_t w) {
+  for (size_t i = 0; i < w; i++) x[i] = ~x[i];
+  add_1(x, w, 1);
+}
+
+// x /= 2, arithmetic shift; x must be even.
+static void half_tc(uint64_t *x, const size_t w) {
+  for (size_t i = 0; i + 1 < w; i++) x[i] = x[i] >> 1 | x[i + 1] << 63;
+  x[w - 1] = static_cast<uint64_t>(static_cast<int64_t>(x[w - 1]) >> 1);
+}
+
+// x /= 3, x must be a multiple of 3.
+static void divexact3_tc(uint64_t *x, const size_t w) {
+  constexpr uint64_t INV3 = 0xAAAAAAAAAAAAAAABull; // 3 * INV3 == 1 mod 2^64
+  uint64_t c = 0, high, low;
+  for (size_t i = 0; i < w; i++) {
+    const uint64_t s = x[i] - c;
+    c = x[i] < c;
+    x[i] = s * INV3;
+    mul64(x[i], 3, high, low);
+    c += high;
+  }
+}
+
+// evaluates a0 + a1 x + a2 x^2 at 1, -1 and 2 into k + 1 limbs each;
+// returns true if the value at -1 is negative (stored as magnitude).
+static bool toom3_eval(const uint64_t *a, const size_t k, const size_t n2,
+                       uint64_t *v1, uint64_t *vm1, uint64_t *v2) {
+  const uint64_t *a0 = a, *a1 = a + k, *a2 = a + 2 * k;
+
+  // v2 = a0 + a2 first, as a temporary
+  const uint64_t carry = add_n(v2, a0, a2, n2);
+  std::copy(a0 + n2, a0 + k, v2 + n2);
+  v2[k] = add_1(v2 + n2, k - n2, carry);
+  std::copy(v2, v2 + k + 1, v1);
+  v1[k] += add_n(v1, v1, a1, k);
+
+  const bool neg = abs_sub(vm1, v2, k + 1, a1, k);
+
+  // v2 = ((a2 * 2 + a1) * 2 + a0)
+  std::copy(a2, a2 + n2, v2);
+  std::fill(v2 + n2, v2 + k + 1, 0);
+  for (size_t i = k + 1; i--;) v2[i] = v2[i] << 1 | (i ? v2[i - 1] >> 63 : 0);
+  v2[k] += add_n(v2, v2, a1, k);
+  for (size_t i = k + 1; i--;) v2[i] = v2[i] << 1 | (i ? v2[i - 1] >> 63 : 0);
+  v2[k] += add_n(v2, v2, a0, k);
+  return neg;
+}
+
+// r[off, n) += x[0, w), where the sum is known to fit in n limbs.
+static void add_at(uint64_t *r, const size_t n, const size_t off,
+                   const uint64_t *x, const size_t w) {
+  const size_t len = std::min(w, n - off);
+  add_1(r + off + len, n - off - len, add_n(r + off, r + off, x, len));
+}
+
+// w1, wm1, w2 hold the (2k + 2)-limb products at 1, -1, 2; r holds the
+// product at 0 in [0, 2k), at inf in [4k, 4k + ninf) and zeros between.
+static void toom3_interpolate(uint64_t *r, const size_t n, const size_t k,
+                              const size_t ninf, uint64_t *w1, uint64_t *wm1,
+                              uint64_t *w2) {
+  const size_t w = 2 * k + 2;
+  const uint64_t *r0 = r, *rinf = r + 4 * k;
+
+  // w2 = (r(2) - r(-1)) / 3 = c1 + c2 + 3c3 + 5c4
+  sub_n(w2, w2, wm1, w);
+  divexact3_tc(w2, w);
+  // wm1 = (r(1) - r(-1)) / 2 = c1 + c3
+  sub_n(wm1, w1, wm1, w);
+  half_tc(wm1, w);
+  // w1 = r(1) - r0 = c1 + c2 + c3 + c4
+  sub_tc(w1, w, r0, 2 * k);
+  // w2 = (w2 - w1) / 2 = c3 + 2c4
+  sub_n(w2, w2, w1, w);
+  half_tc(w2, w);
+  // w1 = w1 - wm1 - rinf = c2
+  sub_n(w1, w1, wm1, w);
+  sub_tc(w1, w, rinf, ninf);
+  // w2 = w2 - 2rinf = c3
+  sub_tc(w2, w, rinf, ninf);
+  sub_tc(w2, w, rinf, ninf);
+  // wm1 = wm1 - w2 = c1
+  sub_n(wm1, wm1, w2, w);
+
+  add_at(r, n, k, wm1, w);
+  add_at(r, n, 2 * k, w1, w);
+  add_at(r, n, 3 * k, w2, w);
+}
+
+// a = a0 + a1 * B^k + a2 * B^2k, same for b; k = ceil(na / 3), nb > 2k.
+// evaluates at 0, 1, -1, 2, inf and interpolates the coefficients c0..c4;
+// intermediates are kept as (2k + 2)-limb two's complement values.
+static void toom3(uint64_t *r, const uint64_t *a, const size_t na,
+                  const uint64_t *b, const size_t nb, uint64_t *tmp) {
+  const size_t k = (na + 2) / 3;
+  const size_t na2 = na - 2 * k, nb2 = nb - 2 * k;
+  const size_t w = 2 * k + 2;
+
+  uint64_t *a1 = tmp, *am1 = a1 + k + 1, *a2 = am1 + k + 1;
+  uint64_t *b1 = a2 + k + 1, *bm1 = b1 + k + 1, *b2 = bm1 + k + 1;
+  uint64_t *w1 = b2 + k + 1, *wm1 = w1 + w, *w2 = wm1 + w;
+  tmp = w2 + w;
+
+  const bool neg = toom3_eval(a, k, na2, a1, am1, a2) ^
+                   toom3_eval(b, k, nb2, b1, bm1, b2);
+  umul_rec(w1, a1, k + 1, b1, k + 1, tmp);
+  umul_rec(wm1, am1, k + 1, bm1, k + 1, tmp);
+  if (neg) neg_tc(wm1, w);
+  umul_rec(w2, a2, k + 1, b2, k + 1, tmp);
+
+  const size_t n = na + nb, ninf = na2 + nb2;
+  umul_rec(r, a, k, b, k, tmp);
+  if (na2 >= nb2) umul_rec(r + 4 * k, a + 2 * k, na2, b + 2 * k, nb2, tmp);
+  else umul_rec(r + 4 * k, b + 2 * k, nb2, a + 2 * k, na2, tmp);
+  std::fill(r + 2 * k, r + 4 * k, 0);
+
+  toom3_interpolate(r, n, k, ninf, w1, wm1, w2);
+}
+
+static void toom3_sqr(uint64_t *r, const uint64_t *a, const size_t n,
+                      uint64_t *tmp) {
+  const size_t k = (n + 2) / 3;
+  const size_t n2 = n - 2 * k;
+  const size_t w = 2 * k + 2;
+
+  uint64_t *a1 = tmp, *am1 = a1 + k + 1, *a2 = am1 + k + 1;
+  uint64_t *w1 = a2 + k + 1, *wm1 = w1 + w, *w2 = wm1 + w;
+  tmp = w2 + w;
+
+  toom3_eval(a, k, n2, a1, am1, a2);
+  usqr_rec(w1, a1, k + 1, tmp);
+  usqr_rec(wm1, am1, k + 1, tmp);
+  usqr_rec(w2, a2, k + 1, tmp);
+
+  usqr_rec(r, a, k, tmp);
+  usqr_rec(r + 4 * k, a + 2 * k, n2, tmp);
+  std::fill(r + 2 * k, r + 4 * k, 0);
+
+  toom3_interpolate(r, 2 * n, k, 2 * n2, w1, wm1, w2);
+}
+
+// na >= nb
+static void umul_rec(uint64_t *r, const uint64_t *a, const size_t na,
+                     const uint64_t *b, const size_t nb, uint64_t *tmp) {
+  if (nb < std::max<size_t>(tuning.mul_karatsuba, 2)) {
+    grade_school(r, a, na, b, nb);
+  } else if (nb >= tuning.mul_ntt) {
+    umul_ntt_(r, a, na, b, nb);
+  } else if (nb >= std::max<size_t>(tuning.mul_toom3, 9) &&
+             nb > 2 * ((na + 2) / 3)) {
+    toom3(r, a, na, b, nb, tmp);
+  } else if (nb > (na + 1) / 2) {
+    karatsuba(r, a, na, b, nb, tmp);
+  } else {
+    umul_chunked(r, a, na, b, nb, tmp);
+  }
+}
+
+void internal::umul_(uint64_t *r, const uint64_t *a, const size_t na,
+                     const uint64_t *b, const size_t nb, uint64_t *tmp) {
+  if (nb < std::max<size_t>(tuning.mul_karatsuba, 2)) {
+    grade_school(r, a, na, b, nb);
+    return;
+  }
+  if (nb >= tuning.mul_ntt) {
+    umul_ntt_(r, a, na, b, nb);
+    return;
+  }
+  if (tmp) {
+    umul_rec(r, a, na, b, nb, tmp);
+    return;
+  }
+  Scratch scratch(mul_itch(na));
+  umul_rec(r, a, na, b, nb, scratch.data());
+}
+
+static void usqr_rec(uint64_t *r, const uint64_t *a, const size_t n,
+                     uint64_t *tmp) {
+  if (n < std::max<size_t>(tuning.sqr_karatsuba, 2)) {
+    sqr_school(r, a, n);
+  } else if (n >= tuning.sqr_ntt) {
+    umul_ntt_(r, a, n, a, n);
+  } else if (n >= std::max<size_t>(tuning.sqr_toom3, 9)) {
+    toom3_sqr(r, a, n, tmp);
+  } else {
+    karatsuba_sqr(r, a, n, tmp);
+  }
+}
+
+void internal::usqr_(uint64_t *r, const uint64_t *a, const size_t n,
+                     uint64_t *tmp) {
+  if (n < std::max<size_t>(tuning.sqr_karatsuba, 2)) {
+    sqr_school(r, a, n);
+    return;
+  }
+  if (n >= tuning.sqr_ntt) {
+    umul_ntt_(r, a, n, a, n);
+    return;
+  }
+  if (tmp) {
+    usqr_rec(r, a, n, tmp);
+    return;
+  }
+  Scratch scratch(mul_itch(n));
+  usqr_rec(r, a, n, scratch.data());
 }
 
 void Integer::mul_64bits(const Integer &a, const int64_t b, Integer &out) {
@@ -44,13 +373,73 @@ void Integer::mul_64bits(const Integer &a, const int64_t b, Integer &out) {
   out.neg_ = a.neg_ ^ (b < 0);
 }
 
+// x = x * y in the buffer of x, nx limbs followed by ny zero limbs: the
+// limbs of x go from the top, each replaced by its row of the product, so
+// every limb is read before a row lands on it.
+static void umul_in_place(uint64_t *x, const size_t nx, const uint64_t *y,
+                          const size_t ny) {
+  for (size_t i = nx; i--;) {
+    const uint64_t t = x[i];
+    x[i] = 0;
+    add_1(x + i + ny, nx - i, addmul_1(x + i, y, ny, t));
+  }
+}
+
 void Integer::mul(const Integer &a, const Integer &b, Integer &out) {
+  if (&a == &b) {
+    sqr(a, out);
+    return;
+  }
   if (a.zero() || b.zero()) {
     out = 0;
     return;
   }
 
-  grade_school(a.abs_val_, b.abs_val_, out.abs_val_);
+  const VecU64 &max = a.abs_val_.size() >= b.abs_val_.size() ? a.abs_val_
+                                                              : b.abs_val_;
+  const VecU64 &min = &max == &a.abs_val_ ? b.abs_val_ : a.abs_val_;
+  const size_t size = max.size() + min.size();
   out.neg_ = a.neg_ ^ b.neg_;
+  if (&out == &a || &out == &b) {
+    // out is one of the operands. below karatsuba the product builds over
+    // it; above, it goes to scratch and is copied back, so out keeps its
+    // buffer.
+    VecU64 &x = out.abs_val_;
+    const VecU64 &y = &x == &max ? min : max;
+    if (min.size() < tuning.mul_karatsuba) {
+      const size_t nx = x.size();
+      x.resize(size);
+      umul_in_place(x.data(), nx, y.data(), y.size());
+    } else {
+      Scratch res(size);
+      umul_(res.data(), max.data(), max.size(), min.data(), min.size());
+      x.assign(res.data(), res.data() + size);
+    }
+  } else {
+    out.abs_val_.resize(size);
+    umul_(out.abs_val_.data(), max.data(), max.size(), min.data(),
+          min.size());
+  }
+  norm_top(out.abs_val_);
+}
+
+void Integer::sqr(const Integer &a, Integer &out) {
+  if (a.zero()) {
+    out = 0;
+    return;
+  }
+
+  const VecU64 &abs_a = a.abs_val_;
+  const size_t size = 2 * abs_a.size();
+  out.neg_ = false;
+  if (&out == &a) {
+    Scratch res(size);
+    usqr_(res.data(), abs_a.data(), abs_a.size());
+    out.abs_val_.assign(res.data(), res.data() + size);
+  } else {
+    out.abs_val_.resize(size);
+    usqr_(out.abs_val_.data(), abs_a.data(), abs_a.size());
+  }
+  norm_top(out.abs_val_);
 }
-} // namespace lll
\ No newline at end of file
+} // namespace lll
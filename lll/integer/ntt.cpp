@@ -0,0 +1,309 @@
+#include "internal.hpp"
+#include "parallel.hpp"
+#include "tuning.hpp"
+#include <algorithm>
+#include <memory>
+#include <mutex>
+
+namespace lll {
+using namespace internal;
+
+// number theoretic transform over three primes p = k * 2^e + 1 < 2^62.
+// a convolution coefficient of 64-bit limbs is below n * 2^128, which fits
+// in p1 * p2 * p3 (~2^184) for any n < 2^55, so limbs need no splitting.
+namespace {
+struct Prime {
+  uint64_t p;
+  uint64_t p_inv; // -p^-1 mod 2^64
+  uint64_t r2;    // 2^128 mod p
+  uint64_t g;     // primitive root
+
+  explicit Prime(const uint64_t prime, const uint64_t root)
+    : p(prime), p_inv(-inv64(prime)), g(root) {
+    const __uint128_t r = (__uint128_t)1 << 64;
+    const uint64_t r1 = (uint64_t)(r % p);
+    r2 = (uint64_t)((__uint128_t)r1 * r1 % p);
+  }
+
+  // a * b / 2^64 mod p, a * b < p * 2^64
+  uint64_t mul(const uint64_t a, const uint64_t b) const {
+    uint64_t t_high, t_low, m_high, m_low, carry;
+    mul64(a, b, t_high, t_low);
+    mul64(t_low * p_inv, p, m_high, m_low);
+    add64(t_low, m_low, 0, carry);
+    const uint64_t u = t_high + m_high + carry;
+    return u >= p ? u - p : u;
+  }
+
+  // a * w mod p in [0, 2p), w_shoup = floor(w * 2^64 / p)
+  uint64_t mul_shoup(const uint64_t a, const uint64_t w,
+                     const uint64_t w_shoup) const {
+    uint64_t q, low;
+    mul64(a, w_shoup, q, low);
+    return a * w - q * p;
+  }
+
+  uint64_t add(const uint64_t a, const uint64_t b) const {
+    const uint64_t s = a + b;
+    return s >= p ? s - p : s;
+  }
+
+  uint64_t sub(const uint64_t a, const uint64_t b) const {
+    return a >= b ? a - b : a + p - b;
+  }
+
+  uint64_t to_mont(const uint64_t a) const { return mul(a, r2); }
+  uint64_t from_mont(const uint64_t a) const { return mul(a, 1); }
+
+  // montgomery form in and out
+  uint64_t pow(uint64_t b, uint64_t e) const {
+    uint64_t out = to_mont(1);
+    for (; e; e /= 2) {
+      if (e & 1) out = mul(out, b);
+      b = mul(b, b);
+    }
+    return out;
+  }
+
+  uint64_t inv(const uint64_t a) const { return pow(a, p - 2); }
+
+  // interleaved {w^j, shoup(w^j)} for j < 2^k, w a primitive 2^(k+1)-th
+  // root of unity (or its inverse). built once per level and kept.
+  const uint64_t *roots(const size_t k, const bool inverse) const {
+    std::lock_guard<std::mutex> guard(mutex_);
+    std::unique_ptr<uint64_t[]> &level = roots_[inverse][k];
+    if (level) return level.get();
+
+    const size_t half = (size_t)1 << k;
+    level.reset(new uint64_t[2 * half]);
+    uint64_t w = pow(to_mont(g), (p - 1) >> (k + 1));
+    if (inverse) w = inv(w);
+    uint64_t x = to_mont(1);
+    for (size_t j = 0; j < half; j++) {
+      const uint64_t plain = from_mont(x);
+      level[2 * j] = plain;
+      level[2 * j + 1] = (uint64_t)(((__uint128_t)plain << 64) / p);
+      x = mul(x, w);
+    }
+    return level.get();
+  }
+
+private:
+  mutable std::mutex mutex_;
+  mutable std::unique_ptr<uint64_t[]> roots_[2][64];
+};
+
+const Prime P1(4179340454199820289ull, 3); // 29 * 2^57 + 1
+const Prime P2(2485986994308513793ull, 5); // 69 * 2^55 + 1
+const Prime P3(1945555039024054273ull, 5); // 27 * 2^56 + 1
+} // namespace
+
+// butterflies below keep values lazily reduced (harvey): the forward
+// transform works in [0, 2p), the inverse in [0, 4p); 4p < 2^64.
+
+// the butterflies j in [j0, j1) of a block x of 2 * half, w = roots(half)
+static void forward_butterflies(const Prime &pr, uint64_t *x,
+                                const size_t half, const uint64_t *w,
+                                const size_t j0, const size_t j1) {
+  const uint64_t p2 = 2 * pr.p;
+  uint64_t *y = x + half;
+  for (size_t j = j0; j < j1; j++) {
+    const uint64_t u = x[j], v = y[j];
+    const uint64_t s = u + v;
+    x[j] = s >= p2 ? s - p2 : s;
+    y[j] = pr.mul_shoup(u - v + p2, w[2 * j], w[2 * j + 1]);
+  }
+}
+
+static void inverse_butterflies(const Prime &pr, uint64_t *x,
+                                const size_t half, const uint64_t *w,
+                                const size_t j0, const size_t j1) {
+  const uint64_t p2 = 2 * pr.p;
+  uint64_t *y = x + half;
+  for (size_t j = j0; j < j1; j++) {
+    const uint64_t u = x[j] >= p2 ? x[j] - p2 : x[j];
+    const uint64_t v = pr.mul_shoup(y[j], w[2 * j], w[2 * j + 1]);
+    x[j] = u + v;
+    y[j] = u - v + p2;
+  }
+}
+
+static size_t log2_size(size_t n) {
+  size_t k = 0;
+  while (n >>= 1) k++;
+  return k;
+}
+
+// f(i, end) for runs splitting [0, n), one per thread
+template <typename F>
+static void each_run(const size_t n, const size_t threads, F f) {
+  const size_t run = (n + threads - 1) / threads;
+  parallel_for(threads, threads, [&](const size_t t) {
+    const size_t i = std::min(n, t * run);
+    f(i, std::min(n, i + run));
+  });
+}
+
+// f(block, j0, j1) over the n / 2 butterflies of one level on blocks of
+// 2 * half, split into one run per thread
+template <typename F>
+static void each_butterfly(uint64_t *a, const size_t n, const size_t half,
+                           const size_t threads, F f) {
+  each_run(n / 2, threads, [&](size_t b, const size_t end) {
+    while (b < end) {
+      const size_t j = b % half, len = std::min(half - j, end - b);
+      f(a + b / half * 2 * half, j, j + len);
+      b += len;
+    }
+  });
+}
+
+// with several threads, the levels on blocks larger than the returned size
+// go one at a time with the butterflies split, and the blocks of that size,
+// at least one per thread, are transformed whole in parallel.
+static size_t ntt_block(const size_t n, const size_t threads) {
+  size_t m = n;
+  while (m > 2 && n / m < threads) m /= 2;
+  return m;
+}
+
+// decimation in frequency, natural order in, bit-reversed order out.
+static void ntt_forward(const Prime &pr, uint64_t *a, const size_t n,
+                        const size_t threads) {
+  const size_t m = ntt_block(n, threads);
+  for (size_t half = n / 2; half >= m; half /= 2) {
+    const uint64_t *w = pr.roots(log2_size(half), false);
+    each_butterfly(a, n, half, threads,
+                   [&](uint64_t *x, const size_t j0, const size_t j1) {
+                     forward_butterflies(pr, x, half, w, j0, j1);
+                   });
+  }
+  parallel_for(n / m, threads, [&](const size_t b) {
+    uint64_t *block = a + b * m;
+    for (size_t half = m / 2; half; half /= 2) {
+      const uint64_t *w = pr.roots(log2_size(half), false);
+      for (size_t i = 0; i < m; i += 2 * half)
+        forward_butterflies(pr, block + i, half, w, 0, half);
+    }
+  });
+}
+
+// decimation in time, bit-reversed order in, natural order out, unscaled.
+static void ntt_inverse(const Prime &pr, uint64_t *a, const size_t n,
+                        const size_t threads) {
+  const size_t m = ntt_block(n, threads);
+  parallel_for(n / m, threads, [&](const size_t b) {
+    uint64_t *block = a + b * m;
+    for (size_t half = 1; half < m; half *= 2) {
+      const uint64_t *w = pr.roots(log2_size(half), true);
+      for (size_t i = 0; i < m; i += 2 * half)
+        inverse_butterflies(pr, block + i, half, w, 0, half);
+    }
+  });
+  for (size_t half = m; half < n; half *= 2) {
+    const uint64_t *w = pr.roots(log2_size(half), true);
+    each_butterfly(a, n, half, threads,
+                   [&](uint64_t *x, const size_t j0, const size_t j1) {
+                     inverse_butterflies(pr, x, half, w, j0, j1);
+                   });
+  }
+}
+
+// f[0, n) = the transform of a[0, na), in montgomery form
+static void transform(const Prime &pr, const uint64_t *a, const size_t na,
+                      const size_t n, uint64_t *f, const size_t threads) {
+  // to_mont accepts any 64-bit limb and reduces it mod p on the way.
+  each_run(n, threads, [&](const size_t i, const size_t end) {
+    for (size_t j = i; j < std::min(end, na); j++) f[j] = pr.to_mont(a[j]);
+    std::fill(f + std::max(i, std::min(end, na)), f + end, 0);
+  });
+  ntt_forward(pr, f, n, threads);
+}
+
+// out[i] = (a * b)[i] mod p for i < n, plain form.
+static void convolve(const Prime &pr, const uint64_t *a, const size_t na,
+                     const uint64_t *b, const size_t nb, const size_t n,
+                     uint64_t *fa, uint64_t *fb, uint64_t *out,
+                     const size_t threads) {
+  transform(pr, a, na, n, fa, threads);
+  if (a == b && na == nb) {
+    each_run(n, threads, [&](const size_t i, const size_t end) {
+      for (size_t j = i; j < end; j++) fa[j] = pr.mul(fa[j], fa[j]);
+    });
+  } else {
+    transform(pr, b, nb, n, fb, threads);
+    each_run(n, threads, [&](const size_t i, const size_t end) {
+      for (size_t j = i; j < end; j++) fa[j] = pr.mul(fa[j], fb[j]);
+    });
+  }
+  ntt_inverse(pr, fa, n, threads);
+
+  // fa holds n * conv * 2^64; one multiply by n^-1 drops both factors.
+  const uint64_t scale = pr.from_mont(pr.inv(pr.to_mont(n % pr.p)));
+  each_run(n, threads, [&](const size_t i, const size_t end) {
+    for (size_t j = i; j < end; j++) out[j] = pr.mul(fa[j], scale);
+  });
+}
+
+// r[0, na + nb) = a * b via three modular convolutions and garner's CRT.
+// products of tuning.mul_parallel limbs and up run on tuning.threads.
+void internal::umul_ntt_(uint64_t *r, const uint64_t *a, const size_t na,
+                         const uint64_t *b, const size_t nb) {
+  const size_t size = na + nb;
+  size_t n = 1;
+  while (n < size - 1) n *= 2;
+  const size_t threads =
+      size >= tuning.mul_parallel ? thread_count(tuning.threads) : 1;
+
+  const bool square = a == b && na == nb;
+  Scratch tmp((square ? 4 : 5) * n);
+  uint64_t *r1 = tmp.data(), *r2 = r1 + n, *r3 = r2 + n;
+  uint64_t *fa = r3 + n, *fb = square ? nullptr : fa + n;
+  convolve(P1, a, na, b, nb, n, fa, fb, r1, threads);
+  convolve(P2, a, na, b, nb, n, fa, fb, r2, threads);
+  convolve(P3, a, na, b, nb, n, fa, fb, r3, threads);
+
+  // montgomery constants: p1^-1 mod p2, (p1 * p2)^-1 mod p3
+  static const uint64_t inv_p1_p2 = P2.inv(P2.to_mont(P1.p % P2.p));
+  static const uint64_t inv_p12_p3 =
+      P3.inv(P3.mul(P3.to_mont(P1.p % P3.p), P3.to_mont(P2.p % P3.p)));
+  static const uint64_t p1_p3 = P3.to_mont(P1.p % P3.p);
+  uint64_t p12_high, p12_low;
+  mul64(P1.p, P2.p, p12_high, p12_low);
+
+  // each coefficient x = v1 + p1 * v2 + p1 * p2 * v3 in three limbs, put
+  // back in place of its residues; then the carries, in order
+  each_run(size - 1, threads, [&](const size_t i, const size_t end) {
+    for (size_t j = i; j < end; j++) {
+      const uint64_t v1 = r1[j];
+      const uint64_t v2 = P2.mul(P2.sub(r2[j], v1 % P2.p), inv_p1_p2);
+      const uint64_t t = P3.add(v1 % P3.p, P3.mul(p1_p3, v2));
+      const uint64_t v3 = P3.mul(P3.sub(r3[j], t), inv_p12_p3);
+
+      uint64_t x0, x1, x2, high, low, carry;
+      mul64(P1.p, v2, x1, x0);
+      x0 = add64(x0, v1, 0, carry);
+      x1 += carry;
+      mul64(p12_low, v3, high, low);
+      x0 = add64(x0, low, 0, carry);
+      x1 = add64(x1, high, carry, carry);
+      x2 = carry;
+      mul64(p12_high, v3, high, low);
+      x1 = add64(x1, low, 0, carry);
+      x2 += high + carry;
+      r1[j] = x0;
+      r2[j] = x1;
+      r3[j] = x2;
+    }
+  });
+
+  uint64_t c0 = 0, c1 = 0;
+  for (size_t i = 0; i < size; i++) {
+    const bool coef = i < size - 1;
+    uint64_t carry;
+    r[i] = add64(c0, coef ? r1[i] : 0, 0, carry);
+    c0 = add64(c1, coef ? r2[i] : 0, carry, carry);
+    c1 = (coef ? r3[i] : 0) + carry;
+  }
+}
+} // namespace lll
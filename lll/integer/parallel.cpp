@@ -0,0 +1,80 @@
+#include "parallel.hpp"
+#include <condition_variable>
+#include <deque>
+#include <vector>
+
+namespace lll {
+using namespace internal;
+
+namespace {
+// a run_parallel call: its tickets wait in the queue until a worker takes
+// one, and the call returns once none is running.
+struct Batch {
+  void (*work)(void *);
+  void *ctx;
+  size_t running;
+};
+
+// workers start on first use and grow to the largest request seen; they
+// sleep on the queue between calls.
+class Pool {
+public:
+  Pool() : stop_(false) {}
+
+  ~Pool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread &t : workers_) t.join();
+  }
+
+  void run(const size_t helpers, void (*work)(void *), void *ctx) {
+    Batch batch = {work, ctx, 0};
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      while (workers_.size() < helpers)
+        workers_.emplace_back([this] { loop(); });
+      queue_.insert(queue_.end(), helpers, &batch);
+    }
+    wake_.notify_all();
+    work(ctx);
+
+    // the tickets still queued have nothing left to help with
+    std::unique_lock<std::mutex> lock(mutex_);
+    queue_.erase(std::remove(queue_.begin(), queue_.end(), &batch),
+                 queue_.end());
+    done_.wait(lock, [&] { return batch.running == 0; });
+  }
+
+private:
+  void loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      wake_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+      if (queue_.empty()) return;
+      Batch *batch = queue_.front();
+      queue_.pop_front();
+      batch->running++;
+      lock.unlock();
+      batch->work(batch->ctx);
+      lock.lock();
+      if (--batch->running == 0) done_.notify_all();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable wake_, done_;
+  std::deque<Batch *> queue_;
+  std::vector<std::thread> workers_;
+  bool stop_;
+};
+} // namespace
+
+void internal::run_parallel(const size_t helpers, void (*work)(void *),
+                            void *ctx) {
+  static Pool pool;
+  pool.run(helpers, work, ctx);
+}
+} // namespace lll
@@ -0,0 +1,69 @@
+#ifndef LLL_INTEGER_PARALLEL_HPP
+#define LLL_INTEGER_PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace lll {
+namespace internal {
+// worker threads for a request of threads, 0 meaning one per core
+static inline size_t thread_count(const size_t threads) {
+  if (threads) return threads;
+  const size_t n = std::thread::hardware_concurrency();
+  return n ? n : 1;
+}
+
+// work(ctx) on the calling thread and on up to helpers threads of a pool
+// kept for the whole process (parallel.cpp), returning once all calls are
+// done. helpers that are busy elsewhere, say in an outer call, are not
+// waited for: work must hand out its items itself, so the caller alone can
+// finish them. work must not throw.
+void run_parallel(size_t helpers, void (*work)(void *), void *ctx);
+
+template <typename F> struct ParallelFor {
+  ParallelFor(F &fn, const size_t count) : f(fn), n(count), next(0) {}
+
+  static void work(void *ctx) {
+    ParallelFor &p = *static_cast<ParallelFor *>(ctx);
+    for (size_t i; (i = p.next++) < p.n;) {
+      try {
+        p.f(i);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(p.mutex);
+        if (!p.error) p.error = std::current_exception();
+        p.next = p.n;
+      }
+    }
+  }
+
+  F &f;
+  const size_t n;
+  std::atomic<size_t> next;
+  std::mutex mutex;
+  std::exception_ptr error;
+};
+
+// f(i) for i in [0, n) on up to thread_count(threads) threads, the caller
+// being one of them; items go out one at a time, so uneven ones balance.
+// if f throws, the items not yet started are dropped and the first
+// exception is rethrown here once every thread is out. with one thread
+// this is a plain loop.
+template <typename F>
+void parallel_for(const size_t n, const size_t threads, F f) {
+  const size_t k = std::min(thread_count(threads), n);
+  if (k <= 1) {
+    for (size_t i = 0; i < n; i++) f(i);
+    return;
+  }
+
+  ParallelFor<F> p(f, n);
+  run_parallel(k - 1, ParallelFor<F>::work, &p);
+  if (p.error) std::rethrow_exception(p.error);
+}
+} // namespace internal
+} // namespace lll
+
+#endif // LLL_INTEGER_PARALLEL_HPP
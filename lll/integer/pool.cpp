@@ -0,0 +1,74 @@
+#include "pool.hpp"
+#include "internal.hpp"
+
+namespace lll {
+using namespace internal;
+
+static thread_local LimbPool *active = nullptr;
+static thread_local LimbStats stats;
+
+// idle Scratch buffers of this thread, at most SPARE_LIMBS of them in all
+// (4 MB) so threads do not sit on memory; anything past that goes back to
+// the heap.
+static thread_local std::vector<VecU64> spare;
+static thread_local size_t spare_limbs = 0;
+constexpr size_t SPARE_LIMBS = (size_t)1 << 19;
+constexpr size_t SPARE_COUNT = 16;
+
+LimbPool::LimbPool() : prev_(active) { active = this; }
+
+LimbPool::~LimbPool() {
+  active = prev_;
+  for (std::vector<uint64_t *> &list : free_) {
+    for (uint64_t *p : list) delete[] p;
+  }
+}
+
+uint64_t *internal::limb_alloc(size_t &cap) {
+  if (active) {
+    size_t size = 2 * LimbVec::INLINE;
+    while (size < cap) size *= 2;
+    cap = size;
+
+    std::vector<uint64_t *> &list = active->free_[63 - clz64(size)];
+    if (!list.empty()) {
+      uint64_t *p = list.back();
+      list.pop_back();
+      stats.reused++;
+      return p;
+    }
+  }
+  stats.heap++;
+  return new uint64_t[cap];
+}
+
+void internal::limb_free(uint64_t *p, const size_t cap) {
+  if (active && (cap & (cap - 1)) == 0) {
+    std::vector<uint64_t *> &list = active->free_[63 - clz64(cap)];
+    if (list.size() < LimbPool::MAX_FREE) {
+      list.push_back(p);
+      return;
+    }
+  }
+  delete[] p;
+}
+
+Scratch::Scratch(const size_t n) {
+  if (!spare.empty()) {
+    buf_ = std::move(spare.back());
+    spare.pop_back();
+    spare_limbs -= buf_.capacity();
+  }
+  buf_.reserve(n);
+}
+
+Scratch::~Scratch() {
+  const size_t cap = buf_.capacity();
+  if (cap <= SPARE_LIMBS - spare_limbs && spare.size() < SPARE_COUNT) {
+    spare_limbs += cap;
+    spare.push_back(std::move(buf_));
+  }
+}
+
+LimbStats limb_stats() { return stats; }
+} // namespace lll
@@ -0,0 +1,46 @@
+#ifndef LLL_INTEGER_POOL_HPP
+#define LLL_INTEGER_POOL_HPP
+
+#include "../integer.hpp"
+#include <vector>
+
+namespace lll {
+// a per-thread size-class pool for limb buffers. while a LimbPool is alive,
+// every heap buffer a LimbVec takes or frees on the constructing thread goes
+// through it: capacities round up to powers of two and freed buffers are
+// kept for reuse instead of returned to the heap. scopes nest; the innermost
+// one is used. buffers are plain heap memory, so Integers may outlive the
+// scope or move to other threads.
+//
+//   {
+//     LimbPool pool;
+//     for (...) out.push_back(pow_mod(b, e, m));
+//   }
+class LimbPool {
+public:
+  // at most this many free buffers are kept per size class
+  static constexpr size_t MAX_FREE = 32;
+
+  LimbPool();
+  ~LimbPool();
+  LimbPool(const LimbPool &) = delete;
+  LimbPool &operator=(const LimbPool &) = delete;
+
+private:
+  friend uint64_t *internal::limb_alloc(size_t &cap);
+  friend void internal::limb_free(uint64_t *p, size_t cap);
+
+  LimbPool *prev_;
+  std::vector<uint64_t *> free_[64]; // by log2 of the capacity
+};
+
+// limb buffers taken on this thread: from the heap, and out of a pool.
+struct LimbStats {
+  uint64_t heap = 0;
+  uint64_t reused = 0;
+};
+
+LimbStats limb_stats();
+} // namespace lll
+
+#endif // LLL_INTEGER_POOL_HPP
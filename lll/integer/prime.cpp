@@ -0,0 +1,364 @@
+#include "divisor.hpp"
+#include "internal.hpp"
+#include "math.hpp"
+#include "modular.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+namespace lll {
+using namespace internal;
+
+// the odd primes below 2^16, sieved once
+static const std::vector<uint32_t> &small_primes() {
+  static const std::vector<uint32_t> primes = [] {
+    const uint32_t n = 1 << 16;
+    std::vector<uint32_t> out;
+    std::vector<bool> comp(n);
+    for (uint32_t i = 3; i < n; i += 2) {
+      if (comp[i]) continue;
+      out.push_back(i);
+      for (uint32_t j = i * i; j < n; j += 2 * i) comp[j] = true;
+    }
+    return out;
+  }();
+  return primes;
+}
+
+// product of the primes p[lo, hi), split in halves so the multiplications
+// are balanced
+static Integer product(const std::vector<uint32_t> &p, const size_t lo,
+                       const size_t hi) {
+  if (hi - lo <= 8) {
+    Integer out = 1;
+    for (size_t i = lo; i < hi; i++) out *= (int64_t)p[i];
+    return out;
+  }
+  const size_t mid = lo + (hi - lo) / 2;
+  return product(p, lo, mid) * product(p, mid, hi);
+}
+
+// the product of the odd primes below 2^j for a j growing with the bits of
+// the candidate: one gcd with it screens like trial division by all of
+// them, for a fraction of a miller-rabin round
+static const Integer &primorial(const uint64_t bits) {
+  static const std::vector<Integer> tiers = [] {
+    const std::vector<uint32_t> &p = small_primes();
+    std::vector<Integer> out;
+    size_t done = 0;
+    Integer acc = 1;
+    for (uint32_t j = 8; j <= 16; j++) {
+      const size_t end =
+          std::lower_bound(p.begin(), p.end(), (uint32_t)1 << j) - p.begin();
+      acc *= product(p, done, end);
+      done = end;
+      out.push_back(acc);
+    }
+    return out;
+  }();
+  const uint64_t j = 63 - clz64(bits) + 4;
+  return tiers[std::min<uint64_t>(std::max<uint64_t>(j, 8), 16) - 8];
+}
+
+// a * b / 2^64 mod n for odd n, a, b < n
+static uint64_t mont_mul64(const uint64_t a, const uint64_t b,
+                           const uint64_t n, const uint64_t n_inv) {
+  uint64_t high, low, mh, ml, carry;
+  mul64(a, b, high, low);
+  mul64(low * n_inv, n, mh, ml);
+  add64(low, ml, 0, carry); // the low word cancels
+  uint64_t t = add64(high, mh, carry, carry);
+  if (carry || t >= n) t -= n;
+  return t;
+}
+
+// strong probable prime tests of an odd word n > 2 to the bases a; the
+// seven bases below settle every n < 2^64 (sinclair)
+static bool is_prime64(const uint64_t n) {
+  static const uint64_t bases[] = {2,      325,     9375,      28178,
+                                   450775, 9780504, 1795265022};
+  const uint64_t n_inv = 0 - inv64(n), s = ctz64(n - 1), d = (n - 1) >> s;
+  const uint64_t one = (0 - n) % n, minus = n - one; // montgomery 1 and -1
+  uint64_t r2;
+  div128(one, 0, n, r2);
+
+  for (const uint64_t a : bases) {
+    const uint64_t b = a % n;
+    if (b == 0) continue;
+
+    uint64_t x = one, y = mont_mul64(b, r2, n, n_inv);
+    for (uint64_t e = d; e; e >>= 1) {
+      if (e & 1) x = mont_mul64(x, y, n, n_inv);
+      y = mont_mul64(y, y, n, n_inv);
+    }
+    if (x == one || x == minus) continue;
+
+    uint64_t i = 1;
+    for (; i < s; i++) {
+      x = mont_mul64(x, x, n, n_inv);
+      if (x == minus) break;
+      if (x == one) return false;
+    }
+    if (i == s) return false;
+  }
+  return true;
+}
+
+// jacobi symbol (a / m) for odd m
+static int jacobi64(uint64_t a, uint64_t m) {
+  int out = 1;
+  a %= m;
+  while (a) {
+    const uint64_t z = ctz64(a);
+    a >>= z;
+    if (z % 2 && (m % 8 == 3 || m % 8 == 5)) out = -out;
+    if (a % 4 == 3 && m % 4 == 3) out = -out;
+    std::swap(a, m);
+    a %= m;
+  }
+  return m == 1 ? out : 0;
+}
+
+// jacobi symbol (d / n) for odd d and odd n > 0, by reciprocity
+static int jacobi(const int64_t d, const Integer &n) {
+  const uint64_t a = abs64(d), n_low = n.abs_low64();
+  int out = jacobi64(Divisor64(a).mod(n), a);
+  if (a % 4 == 3 && n_low % 4 == 3) out = -out;
+  if (d < 0 && n_low % 4 == 3) out = -out;
+  return out;
+}
+
+// strong probable prime to base 2, n odd
+static bool is_sprp2(const Montgomery &mont, const Integer &n) {
+  const Integer m = n - 1;
+  const uint64_t s = m.pow_of_2();
+  const Integer one = mont.to_mont(1), minus = mont.to_mont(m);
+
+  Integer x = mont.to_mont(mont.pow(2, m >> s));
+  if (x == one || x == minus) return true;
+  for (uint64_t i = 1; i < s; i++) {
+    x = mont.sqr(x);
+    if (x == minus) return true;
+    if (x == one) return false;
+  }
+  return false;
+}
+
+// strong lucas probable prime with selfridge's parameters: the first d of
+// 5, -7, 9, -11, ... with (d / n) = -1, p = 1 and q = (1 - d) / 4. n odd,
+// above the small primes and not a square.
+static bool is_slprp(const Montgomery &mont, const Integer &n) {
+  int64_t d = 5;
+  for (int j; (j = jacobi(d, n)) != -1; d = d > 0 ? -d - 2 : -d + 2) {
+    if (j == 0) return false;
+  }
+
+  const auto add = [&n](Integer a, const Integer &b) {
+    a += b;
+    if (a >= n) a -= n;
+    return a;
+  };
+  const auto sub = [&n](Integer a, const Integer &b) {
+    a -= b;
+    if (a.neg()) a += n;
+    return a;
+  };
+  const auto half = [&n](Integer a) {
+    if (a.abs_low64() & 1) a += n;
+    return a >>= 1;
+  };
+  // a * c for a word c: cheaper than a montgomery product
+  const auto mul_small = [&n](Integer a, const int64_t c) {
+    a *= c;
+    a %= n;
+    if (a.neg()) a += n;
+    return a;
+  };
+
+  // u_k, v_k and q^k in montgomery form from k = 1, doubling and stepping
+  // along the bits of e, n + 1 = e * 2^s
+  const Integer m = n + 1;
+  const uint64_t s = m.pow_of_2();
+  const Integer e = m >> s;
+  const int64_t q = (1 - d) / 4;
+  Integer u = mont.to_mont(1), v = u, qk = mont.to_mont(q);
+  const VecU64 &ev = e.view_v();
+  for (uint64_t i = e.abs_log2(); i--;) {
+    u = mont.mul(u, v);
+    v = sub(mont.sqr(v), add(qk, qk));
+    qk = mont.sqr(qk);
+    if (ev[i / 64] >> (i % 64) & 1) {
+      const Integer du = mul_small(u, d);
+      u = half(add(u, v));
+      v = half(add(du, v));
+      qk = mul_small(qk, q);
+    }
+  }
+
+  if (u.zero()) return true;
+  for (uint64_t r = 0; r < s; r++) {
+    if (v.zero()) return true;
+    v = sub(mont.sqr(v), add(qk, qk));
+    qk = mont.sqr(qk);
+  }
+  return false;
+}
+
+// baillie-psw for odd n above the small primes: no composite is known to
+// pass both tests
+static bool is_bpsw(const Integer &n) {
+  const Montgomery mont(n);
+  if (!is_sprp2(mont, n)) return false;
+  Integer rem;
+  sqrtrem(n, rem);
+  return !rem.zero() && is_slprp(mont, n);
+}
+
+bool is_probable_prime(const Integer &n) {
+  if (n < 2) return false;
+
+  const VecU64 &v = n.view_v();
+  if (v.size() == 1) {
+    const uint64_t x = v[0];
+    if (x < 4) return true;
+    if (x % 2 == 0) return false;
+    for (const uint32_t p : {3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37}) {
+      if (x % p == 0) return x == p;
+    }
+    return x < 41 * 41 || is_prime64(x);
+  }
+
+  if (v[0] % 2 == 0) return false;
+  return gcd(n, primorial(bit_size(n))) == 1 && is_bpsw(n);
+}
+
+// trial division to sqrt(n) is out of reach not far above 2^64, so above a
+// word this is bpsw alone
+bool is_prime(const Integer &n) { return is_probable_prime(n); }
+
+// the first prime from x on, x odd and above a word, or 0 past limit if
+// one is given. x mod p is found once for the small primes p; windows of
+// odd candidates are then sieved through those residues, updated as the
+// window moves, and only the survivors pay for bpsw, on up to threads
+// threads. they are handed out in order, so the result is the same for
+// any thread count.
+static Integer prime_search(Integer x, const Integer *limit,
+                            const size_t threads) {
+  const std::vector<uint32_t> &p = small_primes();
+  const uint64_t bits = bit_size(x);
+  const size_t np =
+      std::upper_bound(p.begin(), p.end(),
+                       std::min<uint64_t>(64 * bits, UINT16_MAX)) -
+      p.begin();
+  const size_t w = std::max<size_t>(1024, 4 * bits); // odd candidates
+
+  // residues by words of several primes at a time, one pass over x each
+  std::vector<uint32_t> r(np);
+  for (size_t i = 0; i < np;) {
+    size_t j = i;
+    uint64_t prod = 1;
+    while (j < np && prod <= UINT64_MAX / p[j]) prod *= p[j++];
+    const uint64_t m = Divisor64(prod).mod(x);
+    for (; i < j; i++) r[i] = m % p[i];
+  }
+
+  std::vector<bool> comp(w);
+  std::vector<uint32_t> cand;
+  while (true) {
+    // x + 2k = 0 mod p for k = -x / 2 mod p
+    comp.assign(w, false);
+    for (size_t i = 0; i < np; i++) {
+      const uint64_t pi = p[i];
+      uint64_t k = (pi - r[i]) % pi * ((pi + 1) / 2) % pi;
+      for (; k < w; k += pi) comp[k] = true;
+    }
+    cand.clear();
+    for (uint32_t k = 0; k < w; k++) {
+      if (!comp[k]) cand.push_back(k);
+    }
+
+    std::atomic<size_t> best(cand.size());
+    parallel_for(cand.size(), threads, [&](const size_t j) {
+      if (j > best || !is_bpsw(x + 2 * (int64_t)cand[j])) return;
+      size_t b = best;
+      while (j < b && !best.compare_exchange_weak(b, j)) {}
+    });
+    if (best < cand.size()) {
+      x += 2 * (int64_t)cand[best];
+      return limit && x > *limit ? 0 : x;
+    }
+
+    x += 2 * (int64_t)w;
+    if (limit && x > *limit) return 0;
+    for (size_t i = 0; i < np; i++) r[i] = (r[i] + 2 * w) % p[i];
+  }
+}
+
+Integer next_prime(const Integer &n, const size_t threads) {
+  if (n < 2) return 2;
+
+  Integer x = n + 1;
+  if (x.abs_low64() % 2 == 0) {
+    if (x == 2) return 2;
+    ++x;
+  }
+  // words go straight to the fast word test
+  for (; x.view_v().size() == 1; x += 2) {
+    if (is_probable_prime(x)) return x;
+  }
+  return prime_search(x, nullptr, threads);
+}
+
+Integer random_prime(const uint64_t bits, const size_t threads) {
+  if (bits < 2) throw std::domain_error("bits < 2.");
+
+  const Integer low = Integer(1) << (bits - 1), high = (low << 1) - 1;
+  while (true) {
+    Integer x = Integer::random(low - 1) + low;
+    if (bits <= 64) { // plain rejection: uniform among the primes
+      if (is_probable_prime(x)) return x;
+      continue;
+    }
+    if (x.abs_low64() % 2 == 0) ++x;
+    Integer out = prime_search(x, &high, threads);
+    if (!out.zero()) return out;
+  }
+}
+
+// one miller-rabin round with a random base; false on finding a witness.
+// gives up early, returning true, once another round has found one.
+static bool prime_test_step(const Montgomery &mont, const Integer &n,
+                            const Integer &d, const uint64_t s,
+                            const std::atomic<bool> &done) {
+  const Integer one = mont.to_mont(1), minus = mont.to_mont(n - 1);
+  Integer x = mont.to_mont(mont.pow(Integer::random(n - 4) + 2, d, done));
+  if (done || x == one || x == minus) return true;
+
+  for (uint64_t i = 1; i < s && !done; i++) {
+    x = mont.sqr(x);
+    if (x == minus) return true;
+    if (x == one) return false;
+  }
+  return done;
+}
+
+bool prime_test(const Integer &n, const size_t t, const size_t threads) {
+  if (n < 2) return false;
+  if (n < 4) return true;
+
+  const Integer m = n - 1;
+  const uint64_t s = m.pow_of_2();
+  if (s == 0) return false;
+  const Integer d = m >> s;
+
+  const Montgomery mont(n);
+  std::atomic<bool> composite(false);
+  parallel_for(t, threads, [&](size_t) {
+    if (!composite && !prime_test_step(mont, n, d, s, composite)) {
+      composite = true;
+    }
+  });
+  return !composite;
+}
+} // namespace lll
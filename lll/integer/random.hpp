@@ -0,0 +1,45 @@
+#ifndef LLL_INTEGER_RANDOM_HPP
+#define LLL_INTEGER_RANDOM_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace lll {
+// a source of uniform 64-bit words for Integer::random. each thread draws
+// from its own source: a Xoshiro256 seeded from std::random_device unless
+// reseeded with seed_random or replaced with set_random_source.
+class RandomSource {
+public:
+  virtual ~RandomSource() = default;
+
+  virtual uint64_t next() = 0;
+  // p[0, n) = the next n words; override to skip the call per word
+  virtual void fill(uint64_t *p, size_t n);
+};
+
+// xoshiro256** (blackman and vigna): 256 bits of state, period 2^256 - 1
+// and a handful of instructions per word.
+class Xoshiro256 final : public RandomSource {
+public:
+  // the state is expanded from seed by splitmix64
+  explicit Xoshiro256(uint64_t seed);
+
+  uint64_t next() override;
+  void fill(uint64_t *p, size_t n) override;
+  // advances by 2^128 words: a non-overlapping stream for another thread
+  void jump();
+
+private:
+  uint64_t s_[4];
+};
+
+// the source Integer::random uses on this thread
+RandomSource &random_source();
+// restarts this thread's default source from seed, for reproducible runs
+void seed_random(uint64_t seed);
+// makes Integer::random on this thread draw from src, which must outlive
+// its use; null goes back to the default source
+void set_random_source(RandomSource *src);
+} // namespace lll
+
+#endif // LLL_INTEGER_RANDOM_HPP
@@ -0,0 +1,179 @@
+#include "internal.hpp"
+#include "math.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace lll {
+using namespace internal;
+
+// floor(sqrt(a)) of a word, corrected from the double estimate
+static uint64_t sqrt64(const uint64_t a) {
+  uint64_t s = (uint64_t)std::sqrt((double)a);
+  if (s > UINT32_MAX) s = UINT32_MAX;
+  while (s * s > a) s--;
+  while (s < UINT32_MAX && (s + 1) * (s + 1) <= a) s++;
+  return s;
+}
+
+// bits [0, k) of |a|
+static Integer low_bits(const Integer &a, const uint64_t k) {
+  const VecU64 &v = a.view_v();
+  const size_t n = std::min<size_t>(v.size(), (k + 63) / 64);
+  if (n == 0) return 0;
+
+  Scratch tmp(n);
+  uint64_t *p = tmp.data();
+  std::copy(v.begin(), v.begin() + n, p);
+  if (n * 64 > k) p[n - 1] &= ((uint64_t)1 << (k % 64)) - 1;
+  return Integer::from_limbs(p, n);
+}
+
+// zimmermann's karatsuba square root: s = floor(sqrt(a)), r = a - s ^ 2 for
+// 2 ^ (2m - 2) <= a < 2 ^ (2m). the root of the top half, m - h bits, and a
+// division by twice it give the low h bits of s at once; subtracting q ^ 2
+// leaves r off by at most one step of s.
+static void sqrtrem_(const Integer &a, const uint64_t m, Integer &s,
+                     Integer &r) {
+  if (m <= 32) {
+    const uint64_t x = a.abs_low64(), y = sqrt64(x), z = x - y * y;
+    s = Integer::from_limbs(&y, 1);
+    r = Integer::from_limbs(&z, 1);
+    return;
+  }
+
+  const uint64_t h = m / 2;
+  Integer s1, r1;
+  sqrtrem_(a >> 2 * h, m - h, s1, r1);
+
+  Integer q, u;
+  r1 <<= h;
+  r1 += low_bits(a >> h, h);
+  s1 <<= 1;
+  Integer::div(r1, s1, q, &u);
+  s1 <<= h - 1;
+  s = s1 + q;
+
+  u <<= h;
+  u += low_bits(a, h);
+  Integer::sqr(q, q);
+  r = u - q;
+  if (r.neg()) {
+    r += s;
+    --s;
+    r += s;
+  }
+}
+
+Integer sqrt(const Integer &n) {
+  Integer rem;
+  return sqrtrem(n, rem);
+}
+
+Integer sqrtrem(const Integer &n, Integer &rem) {
+  if (n.neg()) throw std::domain_error("n < 0.");
+
+  Integer s;
+  sqrtrem_(n, (bit_size(n) + 1) / 2, s, rem);
+  return s;
+}
+
+// x from an over-estimate of floor(n ^ (1 / k)), n > 0, k > 1. newton steps
+// from above only decrease, and stop at the root.
+static Integer root_newton(const Integer &n, const uint64_t k, Integer x) {
+  Integer y;
+  while (true) {
+    Integer::div(n, pow(x, k - 1), y);
+    if (y >= x) return x;
+    x *= (int64_t)(k - 1);
+    x += y;
+    x /= (int64_t)k;
+  }
+}
+
+// floor(n ^ (1 / k)), n > 0, k > 1: the root of the top bits seeds newton
+// at half the precision, down to a double estimate.
+static Integer root_(const Integer &n, const uint64_t k) {
+  const uint64_t bits = bit_size(n), size = (bits - 1) / k + 1;
+  if (size <= 32) {
+    const uint64_t e = bits > 64 ? bits - 64 : 0;
+    const Integer t = n >> e;
+    const double est =
+        std::exp2((std::log2((double)t.abs_low64()) + (double)e) / (double)k);
+    return root_newton(n, k, (int64_t)(est * (1 + 1e-9)) + 1);
+  }
+
+  const uint64_t h = size / 2;
+  Integer x = root_(n >> k * h, k) + 1;
+  return root_newton(n, k, x << h);
+}
+
+Integer root(const Integer &n, const uint64_t k) {
+  if (k == 0) throw std::domain_error("k == 0.");
+  if (n.neg() && k % 2 == 0) throw std::domain_error("n < 0 && k % 2 == 0.");
+  if (k == 1 || n.zero()) return n;
+
+  const Integer a = n.abs();
+  Integer out;
+  if (k == 2) out = sqrt(a);
+  else if (bit_size(a) <= k) out = 1;
+  else out = root_(a, k);
+  return n.neg() ? -out : out;
+}
+
+// x ^ e mod 2 ^ 64
+static uint64_t pow64(uint64_t x, uint64_t e) {
+  uint64_t out = 1;
+  for (; e; e >>= 1, x *= x) {
+    if (e & 1) out *= x;
+  }
+  return out;
+}
+
+// |n| = x ^ p for a prime p and |n| > 1 with 2 ^ (p - 1) < |n| < 2 ^ (32p):
+// the three words around a double estimate of the root, checked on the low
+// limb before the full power.
+static bool is_power_small(const Integer &a, const uint64_t p) {
+  const uint64_t bits = bit_size(a), e = bits > 64 ? bits - 64 : 0;
+  const Integer t = a >> e;
+  const uint64_t est = (uint64_t)std::exp2(
+      (std::log2((double)t.abs_low64()) + (double)e) / (double)p);
+  for (uint64_t x = est ? est - 1 : 0; x <= est + 1; x++) {
+    if (pow64(x, p) == a.abs_low64() && pow(x, p) == a) return true;
+  }
+  return false;
+}
+
+static bool is_prime64(const uint64_t p) {
+  if (p < 4) return p > 1;
+  if (p % 2 == 0) return false;
+  for (uint64_t d = 3; d * d <= p; d += 2) {
+    if (p % d == 0) return false;
+  }
+  return true;
+}
+
+bool is_perfect_power(const Integer &n) {
+  const Integer a = n.abs();
+  if (a <= 1) return true;
+
+  // with a = 2 ^ v * odd, the exponent divides v
+  const uint64_t bits = bit_size(a), v = a.pow_of_2();
+  for (uint64_t p = n.neg() ? 3 : 2; p < bits; p++) {
+    if (!is_prime64(p) || (v && v % p)) continue;
+
+    if (p == 2) {
+      // squares hit 12 of the 64 residues mod 64
+      if (!(0x202021202030213 >> (a.abs_low64() & 63) & 1)) continue;
+      Integer rem;
+      sqrtrem(a, rem);
+      if (rem.zero()) return true;
+    } else if ((bits - 1) / p < 32) {
+      if (is_power_small(a, p)) return true;
+    } else if (pow(root_(a, p), p) == a) {
+      return true;
+    }
+  }
+  return false;
+}
+} // namespace lll
@@ -4,8 +4,8 @@ namespace lll {
 using namespace internal;
 
 void Integer::opp(const Integer &a, Integer &out) {
+  if (&out != &a) out.abs_val_ = a.abs_val_;
   out.neg_ = !(a.zero() || a.neg_);
-  out.abs_val_ = a.abs_val_;
 }
 
 static int ucmp_64bits_(const VecU64 &a, const uint64_t b) {
@@ -87,12 +87,9 @@ static void uadd(const VecU64 &a, const VecU64 &b, VecU64 &out) {
   const VecU64 &min = a.size() > b.size() ? b : a;
   const size_t size_max = max.size();
   const size_t size_min = min.size();
-  uint64_t carry = 0;
 
   out.resize(size_max + 1);
-  for (size_t i = 0; i < size_min; i++) {
-    out[i] = add64(max[i], min[i], carry, carry);
-  }
+  uint64_t carry = add_n(out.data(), max.data(), min.data(), size_min);
 
   for (size_t i = size_min; i < size_max; i++) {
     if (carry == 0) {
@@ -138,12 +135,9 @@ void internal::usub_64bits_(const VecU64 &a, const uint64_t b, VecU64 &out) {
 static void usub(const VecU64 &max, const VecU64 &min, VecU64 &out) {
   const size_t size_max = max.size();
   const size_t size_min = min.size();
-  uint64_t borrow = 0;
 
   out.resize(size_max);
-  for (size_t i = 0; i < size_min; i++) {
-    out[i] = sub64(max[i], min[i], borrow, borrow);
-  }
+  uint64_t borrow = sub_n(out.data(), max.data(), min.data(), size_min);
 
   for (size_t i = size_min; i < size_max; i++) {
     if (borrow == 0) {
@@ -0,0 +1,5 @@
+#include "tuning.hpp"
+
+namespace lll {
+Tuning tuning;
+}
@@ -0,0 +1,34 @@
+#ifndef LLL_INTEGER_TUNING_HPP
+#define LLL_INTEGER_TUNING_HPP
+
+#include <cstddef>
+
+namespace lll {
+// limb-count thresholds choosing between algorithm tiers. the defaults suit
+// a typical x86-64 desktop; adjust before doing arithmetic, not concurrently.
+// threads is opt-in: above mul_parallel, products (and the divisions and
+// decimal conversions built on them) split over that many threads; from
+// str_parallel up to there, decimal conversion splits its halves instead.
+// nothing below str_parallel ever starts a thread.
+struct Tuning {
+  size_t mul_karatsuba = 32;    // grade school below
+  size_t mul_toom3 = 160;       // karatsuba below
+  size_t mul_ntt = 3000;        // toom-3 below
+  size_t sqr_karatsuba = 48;    // squaring counterparts of the above
+  size_t sqr_toom3 = 200;
+  size_t sqr_ntt = 3000;
+  size_t div_dc = 40;           // burnikel-ziegler division, knuth below
+  size_t div_reciprocal = 2000; // Divisor, plain division below
+  size_t gcd_lehmer = 4;        // lehmer gcd, binary below
+  size_t gcd_dc = 4000;         // half gcd, lehmer below
+  size_t hgcd_dc = 100;         // half gcd recursion, lehmer steps below
+  size_t str_dc = 30;           // decimal conversion, quadratic loops below
+  size_t mul_parallel = 50000;  // ntt products on threads, one thread below
+  size_t str_parallel = 2000;   // decimal halves on threads, one thread below
+  size_t threads = 1;           // for the above, 0: one per core
+};
+
+extern Tuning tuning;
+} // namespace lll
+
+#endif // LLL_INTEGER_TUNING_HPP
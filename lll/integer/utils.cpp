@@ -1,43 +1,105 @@
+#include "random.hpp"
 #include "internal.hpp"
 #include <random>
 
 namespace lll {
 using namespace internal;
 
-static uint64_t randint64() {
-  static std::random_device rd;
-  static std::mt19937 gen(rd());
-  static std::uniform_int_distribution<uint64_t> dist(0, UINT64_MAX);
-  return dist(gen);
+void RandomSource::fill(uint64_t *p, const size_t n) {
+  for (size_t i = 0; i < n; i++) p[i] = next();
 }
 
-static bool gen_random(const VecU64 &bound, VecU64 &res, const uint64_t mask) {
-  const uint64_t size = bound.size();
-  bool flag = false;
-  for (size_t i = 0; i < size; ++i) {
-    uint64_t val = randint64();
-    if (i == size - 1) val &= mask;
+static inline uint64_t rotl64(const uint64_t x, const int k) {
+  return x << k | x >> (64 - k);
+}
 
-    if (!flag && val > bound[i]) return false;
-    flag |= val < bound[i];
+Xoshiro256::Xoshiro256(uint64_t seed) {
+  for (uint64_t &s : s_) { // splitmix64
+    uint64_t z = seed += 0x9e3779b97f4a7c15;
+    z = (z ^ z >> 30) * 0xbf58476d1ce4e5b9;
+    z = (z ^ z >> 27) * 0x94d049bb133111eb;
+    s = z ^ z >> 31;
+  }
+}
+
+uint64_t Xoshiro256::next() {
+  const uint64_t out = rotl64(s_[1] * 5, 7) * 9, t = s_[1] << 17;
+  s_[2] ^= s_[0];
+  s_[3] ^= s_[1];
+  s_[1] ^= s_[2];
+  s_[0] ^= s_[3];
+  s_[2] ^= t;
+  s_[3] = rotl64(s_[3], 45);
+  return out;
+}
 
-    res[i] = val;
+void Xoshiro256::fill(uint64_t *p, const size_t n) {
+  // the state stays in registers for the whole run
+  uint64_t s0 = s_[0], s1 = s_[1], s2 = s_[2], s3 = s_[3];
+  for (size_t i = 0; i < n; i++) {
+    p[i] = rotl64(s1 * 5, 7) * 9;
+    const uint64_t t = s1 << 17;
+    s2 ^= s0;
+    s3 ^= s1;
+    s1 ^= s2;
+    s0 ^= s3;
+    s2 ^= t;
+    s3 = rotl64(s3, 45);
   }
-  norm(res);
-  return true;
+  s_[0] = s0;
+  s_[1] = s1;
+  s_[2] = s2;
+  s_[3] = s3;
+}
+
+void Xoshiro256::jump() {
+  static const uint64_t poly[] = {0x180ec6d33cfd0aba, 0xd5a61266f0c9392c,
+                                  0xa9582618e03fc9aa, 0x39abdc4529b1661c};
+  uint64_t t[4] = {0, 0, 0, 0};
+  for (const uint64_t w : poly) {
+    for (int b = 0; b < 64; b++) {
+      if (w >> b & 1) {
+        for (int i = 0; i < 4; i++) t[i] ^= s_[i];
+      }
+      next();
+    }
+  }
+  for (int i = 0; i < 4; i++) s_[i] = t[i];
 }
 
+static Xoshiro256 &default_source() {
+  static thread_local Xoshiro256 gen(
+      (uint64_t)std::random_device{}() << 32 ^ std::random_device{}());
+  return gen;
+}
+
+static thread_local RandomSource *current = nullptr;
+
+RandomSource &random_source() {
+  return current ? *current : default_source();
+}
+
+void seed_random(const uint64_t seed) { default_source() = Xoshiro256(seed); }
+
+void set_random_source(RandomSource *src) { current = src; }
+
 Integer Integer::random(const Integer &bound) {
   if (bound.zero()) return 0;
 
+  // whole draws below the top bit of bound, until one is at most bound:
+  // more than half of them are
   const VecView &bound_v = bound.abs_val_;
+  const size_t size = bound_v.size();
   const uint64_t mask = UINT64_MAX >> clz64(bound_v.back());
+  RandomSource &src = random_source();
 
-  VecView res(bound_v.size());
-  while (!gen_random(bound.abs_val_, res, mask));
+  VecView res(size);
+  do {
+    src.fill(res.data(), size);
+    res.back() &= mask;
+  } while (cmp_n(res.data(), bound_v.data(), size) > 0);
   norm(res);
 
   return {!res.empty() && bound.neg_, std::move(res)};
 }
-
-}
\ No newline at end of file
+} // namespace lll
@@ -0,0 +1,126 @@
+#ifndef LLL_INTEGER_WORD_HPP
+#define LLL_INTEGER_WORD_HPP
+
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace lll {
+// arithmetic on single 64-bit words, with nothing else of the library
+// behind it: internal.hpp builds on these, and so can public headers.
+namespace internal {
+// a + b + c, carry = 0, 1, 2
+static inline uint64_t add64(const uint64_t a, const uint64_t b,
+                             const uint64_t c, uint64_t &carry) {
+  uint64_t res = a + b;
+  const uint64_t carry1 = res < b;
+
+  res += c;
+  const uint64_t carry2 = res < c;
+
+  carry = carry1 + carry2;
+  return res;
+}
+
+// a - b - c, borrow = 0, 1, 2
+static inline uint64_t sub64(const uint64_t a, const uint64_t b,
+                             const uint64_t c, uint64_t &borrow) {
+  const uint64_t borrow1 = a < b;
+  uint64_t res = a - b;
+
+  const uint64_t borrow2 = res < c;
+  res -= c;
+
+  borrow = borrow1 + borrow2;
+  return res;
+}
+
+static inline void mul64(const uint64_t a, const uint64_t b, uint64_t &high,
+                         uint64_t &low) {
+#if defined(_MSC_VER)
+  low = _umul128(a, b, &high);
+#elif defined(__GNUC__) || defined(__clang__)
+  const __uint128_t prod = (__uint128_t)a * (__uint128_t)b;
+  low = (uint64_t)prod;
+  high = (uint64_t)(prod >> 64);
+#else
+
+#endif
+}
+
+static inline uint64_t clz64(const uint64_t n) {
+#ifdef _MSC_VER
+  unsigned long res;
+  _BitScanReverse64(&res, n);
+  return 63 - res;
+#elif defined(__GNUC__) || defined(__clang__)
+  return __builtin_clzll(n);
+#endif
+}
+
+static inline uint64_t ctz64(const uint64_t n) {
+#ifdef _MSC_VER
+  unsigned long res;
+  _BitScanForward64(&res, n);
+  return res;
+#elif defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctzll(n);
+#endif
+}
+
+// (high, low) / divisor; the quotient must fit in 64 bits.
+static inline uint64_t div128(const uint64_t high, const uint64_t low,
+                              const uint64_t divisor, uint64_t &rem) {
+#if defined(_MSC_VER)
+  return _udiv128(high, low, divisor, &rem);
+#elif defined(__GNUC__) || defined(__clang__)
+  const __uint128_t dividend = (__uint128_t)high << 64 | (__uint128_t)low;
+  rem = dividend % divisor;
+  return dividend / divisor;
+#else
+
+#endif
+}
+
+// floor((B^2 - 1) / d) - B for d with its top bit set (moller-granlund)
+static inline uint64_t reciprocal64(const uint64_t d) {
+  uint64_t rem;
+  return div128(~d, UINT64_MAX, d, rem);
+}
+
+// (u1, u0) / d through the reciprocal v of d, top bit of d set and u1 < d:
+// one multiply and a couple of rarely taken adjustments instead of div128.
+static inline uint64_t div_2by1(const uint64_t u1, const uint64_t u0,
+                                const uint64_t d, const uint64_t v,
+                                uint64_t &rem) {
+  uint64_t q1, q0, carry;
+  mul64(v, u1, q1, q0);
+  q0 = add64(q0, u0, 0, carry);
+  q1 += u1 + 1 + carry;
+
+  // the estimate is one too large about half the time: adjust with a mask,
+  // a branch here would be mispredicted as often
+  uint64_t r = u0 - q1 * d;
+  const uint64_t mask = -(uint64_t)(r > q0);
+  q1 += mask;
+  r += mask & d;
+  if (r >= d) { // or one too small, very rarely
+    q1++;
+    r -= d;
+  }
+  rem = r;
+  return q1;
+}
+
+// a^-1 mod 2^64, a odd
+static inline uint64_t inv64(const uint64_t a) {
+  uint64_t inv = a; // a * a == 1 mod 8; each newton step doubles the bits
+  for (int i = 0; i < 5; i++) inv *= 2 - a * inv;
+  return inv;
+}
+} // namespace internal
+} // namespace lll
+
+#endif // LLL_INTEGER_WORD_HPP